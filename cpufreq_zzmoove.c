@@ -29,8 +29,29 @@
  */
 
 #include <linux/slab.h>
+#include <linux/ctype.h>
+#include <linux/sort.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/input.h>
+#include <linux/workqueue.h>
+#include <linux/rcupdate.h>
+#include <linux/cpu.h>
+#include <linux/thermal.h>
+#include <linux/percpu.h>
+#include <linux/tick.h>
+#include <linux/kernel_stat.h>
+#include <linux/vmalloc.h>
+#include <linux/mm.h>
+#ifdef CONFIG_FB
+#include <linux/fb.h>
+#endif
+#include <trace/events/power.h>
 #include "cpufreq_governor.h"
 
+#define CREATE_TRACE_POINTS
+#include "cpufreq_zzmoove_trace.h"
+
 // ZZ: for version information tunable
 #define ZZMOOVE_VERSION				"bLE-develop-k49x-010520"
 
@@ -51,26 +72,220 @@
 #define DEF_AFS_THRESHOLD2			(50)	// ZZ: default auto fast scaling step two
 #define DEF_AFS_THRESHOLD3			(75)	// ZZ: default auto fast scaling step three
 #define DEF_AFS_THRESHOLD4			(90)	// ZZ: default auto fast scaling step four
+#define DEF_SCHED_EVENT_RATE_LIMIT		(0)	// ZZ: default rate limit for scheduler event mode in us, disabled here
+#define DEF_FAST_SWITCH				(0)	// ZZ: default for fast switching frequencies if the driver is capable of it, disabled here
+#define DEF_LOAD_PREDICTION			(0)	// ZZ: default for predictive load model, disabled here
+#define DEF_INPUT_BOOST_FREQ			(0)	// ZZ: default input boost frequency, disabled here
+#define DEF_INPUT_BOOST_DURATION		(500)	// ZZ: default input boost duration in ms
+#define MAX_INPUT_BOOST_DURATION		(5000)	// ZZ: maximal input boost duration in ms
+#define ZZ_INPUT_BOOST_RATE_LIMIT		(50)	// ZZ: minimal time in ms between two handled input events
+#define ZZ_MAX_PROFILES				(8)	// ZZ: amount of tunable profile slots
+#define ZZ_PROFILE_NAME_LEN			(16)	// ZZ: maximal length of profile names including termination
+#define MAX_FREQ_TABLE_SIZE			(64)	// ZZ: maximal amount of valid frequency steps held in the scaling index
+#define ZZ_LOAD_HISTORY_SIZE			(16)	// ZZ: size of load history ring buffer for prediction (power of 2)
+#define ZZ_PREDICTION_PERIOD_TOLERANCE		(10)	// ZZ: max average load difference for detecting a periodic load pattern
+#define ZZ_STATS_LOAD_BUCKETS			(10)	// ZZ: amount of load histogram buckets (10% load each)
+#define ZZ_STATS_STEP_BUCKETS			(8)	// ZZ: amount of step size histogram buckets (last one counts all bigger steps)
+#define DEF_HOTPLUG				(0)	// ZZ: default for parking cores at low load, disabled here
+#define DEF_HOTPLUG_MIN_CPUS			(1)	// ZZ: default minimal amount of online cores per policy
+#define DEF_HOTPLUG_HYSTERESIS			(20)	// ZZ: default amount of low load samples before a core is parked
+#define MAX_HOTPLUG_HYSTERESIS			(1000)	// ZZ: maximal amount of low load samples before a core is parked
+#define DEF_IDLE_MAX_FREQ			(0)	// ZZ: default max frequency in idle state, disabled here
+#define ZZ_THERMAL_MAX_TRIPS			(8)	// ZZ: maximal amount of thermal trip points
+#define DEF_THERMAL_HYSTERESIS			(2000)	// ZZ: default thermal hysteresis in millidegree celsius
+#define MAX_THERMAL_HYSTERESIS			(20000)	// ZZ: maximal thermal hysteresis in millidegree celsius
+#define ZZ_THERMAL_POLL_INTERVAL		(100)	// ZZ: minimal time in ms between two temperature readings
+#define ZZ_MAX_COORD				(4)	// ZZ: maximal amount of sibling cluster floor entries per policy
+#define DEF_ADAPTIVE_SAMPLING			(0)	// ZZ: default max stretch factor of sampling rate for adaptive sampling, disabled here
+#define MAX_ADAPTIVE_SAMPLING			(10)	// ZZ: maximal stretch factor of sampling rate for adaptive sampling
+#define ZZ_ADAPTIVE_GRADIENT			(20)	// ZZ: load change from which on the sampling period is shortened
+#define ZZ_ADAPTIVE_MARGIN			(10)	// ZZ: load distance to up threshold from which on the sampling period is shortened
+#define ZZ_ADAPTIVE_STABLE			(5)	// ZZ: max load change for stretching the sampling period
+#define DEF_TRANSITION_HYSTERESIS		(0)	// ZZ: default max transition hysteresis window in ms, disabled here
+#define MAX_TRANSITION_HYSTERESIS		(1000)	// ZZ: maximal transition hysteresis window in ms
+#define ZZ_HYSTERESIS_LATENCY_MULT		(100)	// ZZ: min transition hysteresis window in multiples of transition latency
+#define DEF_IOWAIT_BOOST			(0)	// ZZ: default max iowait boost frequency, disabled here
+#define ZZ_IOWAIT_BOOST_THRESHOLD		(10)	// ZZ: iowait share in percent from which on a sample counts as iowait heavy
+#define DEF_LOAD_AGGREGATION			(0)	// ZZ: default load aggregation mode, max load of all cpus here
+#define DEF_LOAD_AGGREGATION_PERCENTILE		(75)	// ZZ: default percentile for percentile load aggregation
+#define DEF_LOAD_AGGREGATION_DISCOUNT		(25)	// ZZ: default discount in percent for single busy cpu load aggregation
+#define ZZ_AGGREGATION_MAX_CPUS			(32)	// ZZ: maximal amount of cpus per policy taken into account for load aggregation
+#define ZZ_RING_MAGIC				(0x7a7a6d76)	// ZZ: 'zzmv', magic of the sample ring header
+#define ZZ_RING_VERSION				(1)	// ZZ: version of the sample ring record format
+#define ZZ_RING_RECORDS				(4096)	// ZZ: amount of records in the sample ring (power of 2)
+#define ZZ_RING_CPUS				(8)	// ZZ: amount of per cpu loads in a sample record
+#define ZZ_RING_HEADER_SIZE			(PAGE_SIZE)	// ZZ: records start on the page after the header
+#define ZZ_RING_SIZE				(ZZ_RING_HEADER_SIZE + ZZ_RING_RECORDS * sizeof(struct zz_ring_record))
+
+// ZZ: power of a frequency step, as known from the platform energy tables
+struct zz_opp_power {
+	unsigned int freq;				// ZZ: frequency of the step
+	unsigned int power;				// ZZ: power at this step (any unit, only relations are used)
+};
+
+// ZZ: thresholds of a frequency step, used instead of the global ones while running at this step
+struct zz_opp_threshold {
+	unsigned int freq;				// ZZ: frequency of the step
+	unsigned int up;				// ZZ: up threshold at this step
+	unsigned int down;				// ZZ: down threshold at this step
+};
+
+// ZZ: frequency step tables, replaced as a whole on every write and freed by RCU so snapshots only hold a pointer
+struct zz_opp_power_table {
+	struct rcu_head rcu;				// ZZ: for freeing after the last reader is done
+	unsigned int cnt;				// ZZ: amount of entries
+	struct zz_opp_power entry[];			// ZZ: power of each step
+};
+
+struct zz_opp_threshold_table {
+	struct rcu_head rcu;				// ZZ: for freeing after the last reader is done
+	unsigned int cnt;				// ZZ: amount of entries
+	struct zz_opp_threshold entry[];		// ZZ: thresholds of each step
+};
+
+// ZZ: thermal trip point, from this temperature on the soft limit is lowered to the given frequency
+struct zz_thermal_trip {
+	int temp;					// ZZ: temperature in millidegree celsius
+	unsigned int freq;				// ZZ: max frequency at and above this temperature
+};
+
+// ZZ: sibling cluster floor, the policy of this cpu runs at least at freq while we are saturated
+struct zz_coord {
+	unsigned int cpu;				// ZZ: any cpu of the sibling cluster
+	unsigned int freq;				// ZZ: floor frequency for the sibling cluster
+};
+
+// ZZ: tunable profile, a complete set of scaling tunables which is always applied at once
+struct zz_profile {
+	char name[ZZ_PROFILE_NAME_LEN];			// ZZ: name of the profile
+	unsigned int sampling_rate;			// ZZ: 0 = keep the sampling rate as it is
+	unsigned int up_threshold;
+	unsigned int down_threshold;
+	unsigned int sampling_up_factor;
+	unsigned int sampling_down_factor;
+	unsigned int smooth_up;
+	unsigned int scaling_proportional;
+	unsigned int fast_scaling_up;
+	unsigned int fast_scaling_down;
+	unsigned int afs_up;
+	unsigned int afs_down;
+	unsigned int afs_threshold1;
+	unsigned int afs_threshold2;
+	unsigned int afs_threshold3;
+	unsigned int afs_threshold4;
+};
+
+// ZZ: per policy statistics, only written from the sampling path of the policy so no locking is needed
+struct zz_policy_stats {
+	u64 up_decisions;				// ZZ: amount of up scaling decisions
+	u64 down_decisions;				// ZZ: amount of down scaling decisions
+	u64 up_suppressed;				// ZZ: samples skipped by sampling up factor
+	u64 down_suppressed;				// ZZ: samples skipped by sampling down factor
+	u64 table_fallbacks;				// ZZ: current freq not in scaling index, proportional freq used instead
+	u64 hysteresis_suppressed;			// ZZ: reversals refused by transition hysteresis
+	u64 time_in_state[MAX_FREQ_TABLE_SIZE];		// ZZ: time in ns spent at each scaling index step
+	u64 load_hist[ZZ_STATS_LOAD_BUCKETS];		// ZZ: sampled load histogram
+	u64 up_step_hist[ZZ_STATS_STEP_BUCKETS];	// ZZ: histogram of steps taken when scaling up
+	u64 down_step_hist[ZZ_STATS_STEP_BUCKETS];	// ZZ: histogram of steps taken when scaling down
+	u64 energy;					// ZZ: estimated energy in power table units x us
+	u64 work;					// ZZ: work done proxy in busy cycles (load x freq x time)
+	u64 last_update;				// ZZ: time of last time in state accounting
+};
+
+/*
+ * ZZ: sample ring, mapped by userspace through debugfs 'ring'. the header is on the first page and the records
+ * follow on the next one. head and tail are free running record counts, the governor writes the record at
+ * head % records and then advances head, the collector reads the records from tail to head and then advances tail.
+ * samples are dropped (and counted) rather than overwriting records not read yet
+ */
+struct zz_ring_header {
+	u32 magic;					// ZZ: ZZ_RING_MAGIC
+	u32 version;					// ZZ: record format version
+	u32 header_size;				// ZZ: offset of the first record
+	u32 record_size;				// ZZ: size of a record
+	u32 records;					// ZZ: amount of records in the ring
+	u32 cpus;					// ZZ: amount of per cpu loads in a record
+	u32 head;					// ZZ: records written, only written by the governor
+	u32 tail;					// ZZ: records read, only written by the collector
+	u32 dropped;					// ZZ: samples dropped because the ring was full
+};
+
+// ZZ: sample record, the fields of the zzmoove_sample trace event plus the per cpu loads
+struct zz_ring_record {
+	u64 time;					// ZZ: time of the sample in ns
+	u32 cur_freq;					// ZZ: freq before the sample
+	u32 requested_freq;				// ZZ: freq requested after the sample
+	u32 interval;					// ZZ: sampling period ended by the sample in us
+	u32 up_skip;					// ZZ: sampling up factor skip counter
+	u32 down_skip;					// ZZ: sampling down factor skip counter
+	u8 load;					// ZZ: load used for decisions
+	u8 prev_load;					// ZZ: load of the previous sample
+	s8 direction;					// ZZ: decision of the sample (1 = up, -1 = down, 0 = none)
+	u8 afs_scaling_up;				// ZZ: auto fast scaling up level
+	u8 afs_scaling_down;				// ZZ: auto fast scaling down level
+	u8 cpu_cnt;					// ZZ: amount of valid per cpu loads (0 = not known yet)
+	u8 reserved[6];
+	u8 cpu_load[ZZ_RING_CPUS];			// ZZ: load of each cpu of the policy
+};
 
 struct zz_policy_dbs_info {
 	struct cpu_dbs_info cdbs;
 	struct policy_dbs_info policy_dbs;
 	struct cpufreq_frequency_table *freq_table;
-	unsigned int down_skip;				// ZZ: down skip value for sampling down factor
-	unsigned int up_skip;				// ZZ: up skip value for sampling up factor
+	unsigned int down_skip;				// ZZ: down skip value for sampling down factor (percent of sampling rate in adaptive mode)
+	unsigned int up_skip;				// ZZ: up skip value for sampling up factor (percent of sampling rate in adaptive mode)
 	unsigned int pol_max;				// ZZ: holds actual max policy
 	unsigned int pol_min;				// ZZ: holds actual min policy
 	unsigned int requested_freq;			// ZZ: holds last requested frequency
-	bool freq_table_desc;				// ZZ: flag for table order ascending or descending (=true)
-	bool scaling_init_eval_done;			// ZZ: flag for initial scaling range evaluation
-	unsigned int freq_table_size;			// ZZ: size of freq table (index count)
+	unsigned int freq_table_size;			// ZZ: amount of valid steps in the scaling index
+	unsigned int freq_index[MAX_FREQ_TABLE_SIZE];	// ZZ: compacted scaling index, valid freqs only in ascending order
+	unsigned int cur_freq_index;			// ZZ: cached scaling index position of the current freq
 	unsigned int zz_prev_load;			// ZZ: previous load saved for afs calculation
-	unsigned int min_scaling_freq;			// ZZ: saved min freq for range detection
-	unsigned int limit_table_start;			// ZZ: table start index for range detection
-	unsigned int limit_table_end;			// ZZ: table end index for range detection
-	unsigned int max_scaling_freq_hard;		// ZZ: hard limit table max index
-	unsigned int min_scaling_freq_hard;		// ZZ: hard limit table min index
-	unsigned int max_scaling_freq_soft;		// ZZ: soft limit table index
+	unsigned int afs_scaling_up;			// ZZ: auto fast scaling up level of this policy
+	unsigned int afs_scaling_down;			// ZZ: auto fast scaling down level of this policy
+	u64 last_full_sample_time;			// ZZ: time of last full sampling period in scheduler event mode
+	u64 event_last_time;				// ZZ: time of last sample in scheduler event mode
+	u64 event_load_sum;				// ZZ: sum of loads x time in us sampled in current period in scheduler event mode
+	u64 event_max_load_sum;				// ZZ: sum of max loads of all cpus x time in us in current period in scheduler event mode
+	u64 event_time;					// ZZ: time in us covered by the loads in current period in scheduler event mode
+	unsigned int load_history[ZZ_LOAD_HISTORY_SIZE];	// ZZ: ring buffer of sampled loads for prediction
+	unsigned int load_history_pos;			// ZZ: next write position in load history
+	unsigned int load_history_cnt;			// ZZ: amount of valid loads in load history
+	int load_level;					// ZZ: smoothed load level for prediction (8 bit fixed point)
+	int load_trend;					// ZZ: smoothed load trend for prediction (8 bit fixed point)
+	unsigned int max_scaling_freq_hard;		// ZZ: hard limit scaling index max
+	unsigned int min_scaling_freq_hard;		// ZZ: hard limit scaling index min
+	unsigned int max_scaling_freq_soft;		// ZZ: soft limit scaling index max
+	unsigned int soft_limit_cap;			// ZZ: frequency cap the soft limit was evaluated for (0 = none)
+	int thermal_temp;				// ZZ: last temperature read from the thermal zone
+	int thermal_trip;				// ZZ: active thermal trip point (-1 = none)
+	u64 thermal_last_poll;				// ZZ: time of last temperature reading
+	struct zz_coord coord[ZZ_MAX_COORD];		// ZZ: sibling floors raised by this policy
+	unsigned int coord_cnt;				// ZZ: amount of sibling floors raised by this policy
+	unsigned int coord_gen;				// ZZ: sibling floor table generation the floors were raised for
+	unsigned int sample_interval;			// ZZ: actual sampling period in adaptive sampling mode (0 = sampling rate)
+	u64 last_transition_time;			// ZZ: time of last frequency transition
+	int last_transition_dir;			// ZZ: direction of last frequency transition (0 = none)
+	bool reversal_seen;				// ZZ: flag for reversal of last transition requested already
+	u64 reversal_period;				// ZZ: average time in ns after which the last transition was reversed
+	unsigned int iowait_boost_freq;			// ZZ: actual iowait boost floor (0 = none)
+	bool cpu_loads_tracked;				// ZZ: flag for per cpu loads tracked in the previous sample
+	unsigned int opp_power[MAX_FREQ_TABLE_SIZE];	// ZZ: power of each scaling index step (0 = unknown)
+	bool opp_efficient[MAX_FREQ_TABLE_SIZE];	// ZZ: flag for scaling index steps no higher step beats in energy per work
+	bool opp_power_valid;				// ZZ: flag for power known for at least one scaling index step
+	unsigned int opp_power_gen;			// ZZ: power table generation the flags above were evaluated for
+	unsigned char opp_up_threshold[MAX_FREQ_TABLE_SIZE];	// ZZ: up threshold of each scaling index step (0 = global)
+	unsigned char opp_down_threshold[MAX_FREQ_TABLE_SIZE];	// ZZ: down threshold of each scaling index step (0 = global)
+	unsigned int opp_thresholds_gen;		// ZZ: threshold table generation the thresholds above were mapped for
+	struct zz_policy_stats stats;			// ZZ: statistics of this policy
+	bool stats_reset;				// ZZ: flag for resetting statistics at next sample
+	struct dentry *debugfs_dir;			// ZZ: debugfs directory of this policy
+	struct zz_ring_header *ring;			// ZZ: sample ring, allocated at first open of debugfs 'ring'
+	u32 ring_head;					// ZZ: records written to the sample ring
+	u64 input_boost_until;				// ZZ: time in ns until input boost is active
+	struct list_head zz_list;			// ZZ: entry in list of all zzmoove policies
+	unsigned int hotplug_up_skip;			// ZZ: samples in a row asking for one more core
+	unsigned int hotplug_down_skip;			// ZZ: samples in a row asking for one core less
 };
 
 static inline struct zz_policy_dbs_info *to_dbs_info(struct policy_dbs_info *policy_dbs)
@@ -96,60 +311,405 @@ struct zz_dbs_tuners {
 	unsigned int afs_threshold2;			// ZZ: zzmoove tunable
 	unsigned int afs_threshold3;			// ZZ: zzmoove tunable
 	unsigned int afs_threshold4;			// ZZ: zzmoove tunable
+	unsigned int sched_event_rate_limit;		// ZZ: zzmoove tunable
+	unsigned int fast_switch;			// ZZ: zzmoove tunable
+	unsigned int load_prediction;			// ZZ: zzmoove tunable
+	struct zz_opp_power_table __rcu *opp_power;	// ZZ: zzmoove tunable (NULL = no table)
+	unsigned int opp_power_gen;			// ZZ: power table generation, changed on every write
+	struct zz_opp_threshold_table __rcu *opp_thresholds;	// ZZ: zzmoove tunable (NULL = no table)
+	unsigned int opp_thresholds_gen;		// ZZ: threshold table generation, changed on every write
+	unsigned int input_boost_freq;			// ZZ: zzmoove tunable
+	unsigned int input_boost_duration;		// ZZ: zzmoove tunable
+	unsigned int hotplug;				// ZZ: zzmoove tunable
+	unsigned int hotplug_min_cpus;			// ZZ: zzmoove tunable
+	unsigned int hotplug_hysteresis;		// ZZ: zzmoove tunable
+	unsigned int idle;				// ZZ: zzmoove tunable
+	char idle_profile[ZZ_PROFILE_NAME_LEN];		// ZZ: zzmoove tunable
+	unsigned int idle_max_freq;			// ZZ: zzmoove tunable
+	char thermal_zone[THERMAL_NAME_LENGTH];		// ZZ: zzmoove tunable
+	struct zz_thermal_trip thermal_trips[ZZ_THERMAL_MAX_TRIPS];	// ZZ: zzmoove tunable
+	unsigned int thermal_trip_cnt;			// ZZ: amount of thermal trip points
+	unsigned int thermal_hysteresis;		// ZZ: zzmoove tunable
+	struct zz_coord coord[ZZ_MAX_COORD];		// ZZ: zzmoove tunable
+	unsigned int coord_cnt;				// ZZ: amount of sibling floor entries
+	unsigned int coord_gen;				// ZZ: sibling floor table generation, changed on every write
+	unsigned int adaptive_sampling;			// ZZ: zzmoove tunable
+	unsigned int transition_hysteresis;		// ZZ: zzmoove tunable
+	unsigned int iowait_boost;			// ZZ: zzmoove tunable
+	unsigned int load_aggregation;			// ZZ: zzmoove tunable
+	unsigned int load_aggregation_percentile;	// ZZ: zzmoove tunable
+	unsigned int load_aggregation_discount;		// ZZ: zzmoove tunable
+	struct zz_tuners_snap __rcu *snap;		// ZZ: published copy of the tunables for the sampling path
+};
+
+/*
+ * ZZ: immutable copy of the tunables (including the common ones held in dbs_data) for the sampling path. writers
+ * change the tuners above and publish a new copy, the sampling path picks up the current one once per sample and
+ * so every decision sees one consistent configuration without ever waiting for a writer
+ */
+struct zz_tuners_snap {
+	struct zz_dbs_tuners tuners;			// ZZ: tunables at the time of publishing
+	struct rcu_head rcu;				// ZZ: for freeing after the last reader is done
+};
+
+// ZZ: tuners as allocated for dbs data, with the parts the sampling path never reads kept out of the snapshots
+struct zz_tuners_ext {
+	struct zz_dbs_tuners tuners;			// ZZ: tunables published to the sampling path
+	struct zz_profile profiles[ZZ_MAX_PROFILES];	// ZZ: tunable profile slots
+	unsigned int profile_cnt;			// ZZ: amount of used profile slots
+	int profile_active;				// ZZ: slot of last loaded profile (-1 = none)
+	struct zz_profile idle_saved;			// ZZ: tunables saved when the idle profile was loaded
+	int idle_saved_active;				// ZZ: active profile slot saved when the idle profile was loaded
+	bool idle_profile_loaded;			// ZZ: flag for idle profile loaded on entering idle state
 };
 
-// ZZ: function for frequency table order detection and limit optimization
-static inline void evaluate_scaling_order_limit_range(struct cpufreq_policy *policy)
+static inline struct zz_tuners_ext *to_tuners_ext(struct dbs_data *dbs_data)
+{
+	return container_of((struct zz_dbs_tuners *)dbs_data->tuners, struct zz_tuners_ext, tuners);
+}
+
+// ZZ: list of all policies governed by zzmoove, for events not belonging to a single policy
+static LIST_HEAD(zz_policy_list);
+static DEFINE_MUTEX(zz_policy_list_lock);
+
+/*
+ * ZZ: publish the actual tunables as a new snapshot for the sampling path, the old one is freed after all samples
+ * still using it are done. writers are serialized by the update lock of the attribute set. if there is no memory for
+ * a new snapshot the tunables are rolled back to the published ones, so sysfs never shows values the sampling path
+ * doesn't use. writers therefore do all other changes only after publishing succeeded
+ */
+static int zz_publish_tuners(struct dbs_data *dbs_data)
+{
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	struct zz_tuners_snap *snap, *old;
+
+	old = rcu_dereference_protected(zz_tuners->snap, true);
+	snap = kmalloc(sizeof(*snap), GFP_KERNEL);
+
+	if (!snap) {
+	    if (old) {
+		*zz_tuners = old->tuners;
+		RCU_INIT_POINTER(zz_tuners->snap, old);
+		dbs_data->ignore_nice_load = old->tuners.ignore_nice_load;
+		dbs_data->sampling_down_factor = old->tuners.sampling_down_factor;
+		dbs_data->up_threshold = old->tuners.up_threshold;
+	    }
+	    return -ENOMEM;
+	}
+
+	// ZZ: sampling rate is not part of it as the governor core owns that tunable, it's read from dbs data directly
+	snap->tuners = *zz_tuners;
+	snap->tuners.ignore_nice_load = dbs_data->ignore_nice_load;
+	snap->tuners.sampling_down_factor = dbs_data->sampling_down_factor;
+	snap->tuners.up_threshold = dbs_data->up_threshold;
+	RCU_INIT_POINTER(snap->tuners.snap, NULL);
+
+	rcu_assign_pointer(zz_tuners->snap, snap);
+
+	if (old)
+	    kfree_rcu(old, rcu);
+
+	return 0;
+}
+
+// ZZ: compare function for sorting the scaling index
+static int zz_freq_cmp(const void *a, const void *b)
+{
+	unsigned int freq_a = *(const unsigned int *)a;
+	unsigned int freq_b = *(const unsigned int *)b;
+
+	return (freq_a > freq_b) - (freq_a < freq_b);
+}
+
+// ZZ: binary search for the highest scaling index with a freq not above the given one (lowest index if all are above)
+static unsigned int zz_freq_floor_index(struct zz_policy_dbs_info *dbs_info, unsigned int freq)
+{
+	unsigned int lo = 0;
+	unsigned int hi = dbs_info->freq_table_size;
+	unsigned int mid;
+
+	while (lo + 1 < hi) {
+	    mid = lo + (hi - lo) / 2;
+	    if (dbs_info->freq_index[mid] <= freq)
+		lo = mid;
+	    else
+		hi = mid;
+	}
+
+	return lo;
+}
+
+// ZZ: binary search for the lowest scaling index with a freq not below the given one (highest index if all are below)
+static unsigned int zz_freq_ceil_index(struct zz_policy_dbs_info *dbs_info, unsigned int freq)
+{
+	unsigned int i = zz_freq_floor_index(dbs_info, freq);
+
+	if (dbs_info->freq_index[i] < freq && i + 1 < dbs_info->freq_table_size)
+	    i++;
+
+	return i;
+}
+
+/*
+ * ZZ: return the scaling index position of the given freq or -1 if it is not in the index. the cached position
+ * is checked first so in the usual case (driver set exactly what we requested last time) no search is needed
+ */
+static inline int zz_get_freq_index(struct zz_policy_dbs_info *dbs_info, unsigned int freq)
+{
+	unsigned int i = dbs_info->cur_freq_index;
+
+	if (likely(i < dbs_info->freq_table_size && dbs_info->freq_index[i] == freq))
+	    return i;
+
+	if (unlikely(!dbs_info->freq_table_size))
+	    return -1;
+
+	i = zz_freq_floor_index(dbs_info, freq);
+
+	if (dbs_info->freq_index[i] != freq)
+	    return -1;
+
+	dbs_info->cur_freq_index = i;
+	return i;
+}
+
+/*
+ * ZZ: map the power table to the scaling index and flag all efficient steps. a step is inefficient if a higher step
+ * has lower or equal power per frequency (= energy per work), so racing to the higher step would cost less energy
+ */
+static void zz_evaluate_opp_power(struct zz_policy_dbs_info *dbs_info, struct zz_dbs_tuners *zz_tuners)
+{
+	struct zz_opp_power_table *tbl = rcu_dereference(zz_tuners->opp_power);
+	unsigned int i, j;
+	int best = -1;
+
+	dbs_info->opp_power_valid = false;
+	dbs_info->opp_power_gen = zz_tuners->opp_power_gen;
+
+	for (i = 0; i < dbs_info->freq_table_size; i++) {
+		dbs_info->opp_power[i] = 0;
+		for (j = 0; tbl && j < tbl->cnt; j++) {
+			if (tbl->entry[j].freq == dbs_info->freq_index[i]) {
+			    dbs_info->opp_power[i] = tbl->entry[j].power;
+			    dbs_info->opp_power_valid = true;
+			    break;
+			}
+		}
+	}
+
+	for (i = dbs_info->freq_table_size; i-- > 0; ) {
+		if (!dbs_info->opp_power[i] || (best >= 0 && (u64)dbs_info->opp_power[best] * dbs_info->freq_index[i]
+		    <= (u64)dbs_info->opp_power[i] * dbs_info->freq_index[best])) {
+		    dbs_info->opp_efficient[i] = false;
+		} else {
+		    dbs_info->opp_efficient[i] = true;
+		    best = i;
+		}
+	}
+}
+
+/*
+ * ZZ: energy aware target. the required capacity is the current freq scaled by load relative to up threshold so we land
+ * below up threshold after the change, the target is the lowest efficient step providing it within soft/hard limits
+ */
+static inline unsigned int zz_get_energy_freq(struct zz_policy_dbs_info *dbs_info, unsigned int curfreq,
+	unsigned int load, unsigned int up_threshold)
+{
+	unsigned int required = div_u64((u64)curfreq * load, up_threshold);
+	unsigned int i = zz_freq_ceil_index(dbs_info, required);
+
+	i = clamp(i, dbs_info->min_scaling_freq_hard, dbs_info->max_scaling_freq_soft);
+
+	while (i < dbs_info->max_scaling_freq_soft && !dbs_info->opp_efficient[i])
+		i++;
+
+	return dbs_info->freq_index[i];
+}
+
+// ZZ: map the threshold table to the scaling index, steps without an entry use the global thresholds
+static void zz_evaluate_opp_thresholds(struct zz_policy_dbs_info *dbs_info, struct zz_dbs_tuners *zz_tuners)
+{
+	struct zz_opp_threshold_table *tbl = rcu_dereference(zz_tuners->opp_thresholds);
+	unsigned int i, j;
+
+	dbs_info->opp_thresholds_gen = zz_tuners->opp_thresholds_gen;
+
+	for (i = 0; i < dbs_info->freq_table_size; i++) {
+		dbs_info->opp_up_threshold[i] = 0;
+		dbs_info->opp_down_threshold[i] = 0;
+		for (j = 0; tbl && j < tbl->cnt; j++) {
+			if (tbl->entry[j].freq == dbs_info->freq_index[i]) {
+			    dbs_info->opp_up_threshold[i] = tbl->entry[j].up;
+			    dbs_info->opp_down_threshold[i] = tbl->entry[j].down;
+			    break;
+			}
+		}
+	}
+}
+
+/*
+ * ZZ: function for building the scaling index and limit optimization. all valid frequencies of the system table are
+ * compacted into an ascending index (invalid entries skipped, duplicates dropped) so the table order and any gaps at
+ * the start of tables without OC capability don't matter anymore and the next step is a plain index calculation.
+ * the index is built once at governor start, later limit changes are only mapped to it (see zz_update_limits)
+ */
+static void evaluate_scaling_order_limit_range(struct cpufreq_policy *policy, struct zz_dbs_tuners *zz_tuners)
 {
 	struct policy_dbs_info *policy_dbs = policy->governor_data;
 	struct zz_policy_dbs_info *dbs_info = to_dbs_info(policy_dbs);
-	int i = 0;
-	int calc_index = 0;
+	struct cpufreq_frequency_table *pos;
+	unsigned int i = 0;
+	unsigned int size = 0;
+	unsigned int lowest = UINT_MAX, highest = 0;
 
 	// ZZ: init dbs variables
 	dbs_info->freq_table_size = 0;
-	dbs_info->freq_table_desc = false;
+	dbs_info->cur_freq_index = 0;
 	dbs_info->max_scaling_freq_hard = 0;
 	dbs_info->max_scaling_freq_soft = 0;
+	dbs_info->soft_limit_cap = 0;
 	dbs_info->min_scaling_freq_hard = 0;
-	dbs_info->min_scaling_freq = 0;
-	dbs_info->limit_table_start = 0;
-	dbs_info->limit_table_end = CPUFREQ_TABLE_END;
-
-	// ZZ: initialisation of freq search in scaling table
-	for (i = 0; (likely(dbs_info->freq_table[i].frequency != CPUFREQ_TABLE_END)); i++) {
-		if (unlikely(dbs_info->pol_max == dbs_info->freq_table[i].frequency))
-			dbs_info->max_scaling_freq_hard = dbs_info->max_scaling_freq_soft = i;		// ZZ: init soft and hard max value
-		if (unlikely(dbs_info->pol_min == dbs_info->freq_table[i].frequency))
-			dbs_info->min_scaling_freq_hard = i;						// ZZ: init hard min value
-	/*
-	 * Yank: continue looping until table end is reached,
-	 * we need this to set the table size limit below
-	 */
+	dbs_info->opp_power_valid = false;
+
+	if (unlikely(!dbs_info->freq_table))
+	    return;
+
+	// ZZ: the lowest and highest frequency always go into the index, so all limits stay reachable on oversized tables
+	cpufreq_for_each_valid_entry(pos, dbs_info->freq_table) {
+		lowest = min(lowest, pos->frequency);
+		highest = max(highest, pos->frequency);
+	}
+
+	if (unlikely(!highest))
+	    return;
+
+	dbs_info->freq_index[size++] = lowest;
+
+	if (highest != lowest)
+	    dbs_info->freq_index[size++] = highest;
+
+	// ZZ: collect all other valid frequencies in whatever order the system table has them
+	cpufreq_for_each_valid_entry(pos, dbs_info->freq_table) {
+		if (pos->frequency == lowest || pos->frequency == highest)
+		    continue;
+
+		if (unlikely(size == MAX_FREQ_TABLE_SIZE)) {
+		    pr_warn_once("zzmoove: frequency table exceeds %d valid steps, ignoring some steps between min and max\n",
+			MAX_FREQ_TABLE_SIZE);
+		    break;
+		}
+		dbs_info->freq_index[size++] = pos->frequency;
+	}
+
+	// ZZ: sort ascending and drop duplicate frequencies
+	sort(dbs_info->freq_index, size, sizeof(dbs_info->freq_index[0]), zz_freq_cmp, NULL);
+
+	for (i = 1, dbs_info->freq_table_size = 1; i < size; i++) {
+		if (dbs_info->freq_index[i] != dbs_info->freq_index[dbs_info->freq_table_size - 1])
+		    dbs_info->freq_index[dbs_info->freq_table_size++] = dbs_info->freq_index[i];
+	}
+
+	// ZZ: map policy limits to scaling index positions
+	dbs_info->max_scaling_freq_hard = dbs_info->max_scaling_freq_soft = zz_freq_floor_index(dbs_info, dbs_info->pol_max);
+	dbs_info->min_scaling_freq_hard = zz_freq_ceil_index(dbs_info, dbs_info->pol_min);
+	dbs_info->cur_freq_index = zz_freq_floor_index(dbs_info, policy->cur);
+
+	zz_evaluate_opp_power(dbs_info, zz_tuners);
+	zz_evaluate_opp_thresholds(dbs_info, zz_tuners);
+}
+
+// ZZ: map a frequency cap (0 = none) to the soft limit, which always stays within the hard limits
+static void zz_update_soft_limit(struct zz_policy_dbs_info *dbs_info, unsigned int cap)
+{
+	dbs_info->soft_limit_cap = cap;
+	dbs_info->max_scaling_freq_soft = dbs_info->max_scaling_freq_hard;
+
+	if (!cap || unlikely(!dbs_info->freq_table_size))
+	    return;
+
+	dbs_info->max_scaling_freq_soft = clamp(zz_freq_floor_index(dbs_info, cap), dbs_info->min_scaling_freq_hard,
+	    dbs_info->max_scaling_freq_hard);
+}
+
+/*
+ * ZZ: frequency cap of the thermal trip points for the last read temperature (0 = none). a trip point becomes active
+ * when its temperature is reached and stays active until the temperature falls below it by the hysteresis
+ */
+static unsigned int zz_get_thermal_cap(struct zz_policy_dbs_info *dbs_info, struct zz_dbs_tuners *zz_tuners)
+{
+	int i = min_t(int, dbs_info->thermal_trip, (int)zz_tuners->thermal_trip_cnt - 1);
+	int temp = dbs_info->thermal_temp;
+
+	if (!zz_tuners->thermal_zone[0] || !zz_tuners->thermal_trip_cnt) {
+	    dbs_info->thermal_trip = -1;
+	    return 0;
+	}
+
+	while (i + 1 < (int)zz_tuners->thermal_trip_cnt && temp >= zz_tuners->thermal_trips[i + 1].temp)
+	    i++;
+
+	while (i >= 0 && temp < zz_tuners->thermal_trips[i].temp - (int)zz_tuners->thermal_hysteresis)
+	    i--;
+
+	dbs_info->thermal_trip = i;
+
+	return i < 0 ? 0 : zz_tuners->thermal_trips[i].freq;
+}
+
+/*
+ * ZZ: read the temperature for the next samples, rate limited as reading a zone can be expensive and may sleep. the
+ * zone is looked up by name on every read as it can go away at any time (driver unbind, module unload), without it
+ * there is no limit anymore until it is back
+ */
+static void zz_thermal_poll(struct zz_policy_dbs_info *dbs_info, const char *zone, u64 now)
+{
+	struct thermal_zone_device *tz;
+	int temp;
+
+	if (now - dbs_info->thermal_last_poll < ZZ_THERMAL_POLL_INTERVAL * NSEC_PER_MSEC)
+	    return;
+
+	dbs_info->thermal_last_poll = now;
+	tz = thermal_zone_get_zone_by_name(zone);
+
+	if (IS_ERR(tz)) {
+	    dbs_info->thermal_temp = 0;
+	    return;
 	}
 
-	dbs_info->freq_table_size = i - 1;								// Yank: upper index limit of freq. table
+	if (!thermal_zone_get_temp(tz, &temp))
+	    dbs_info->thermal_temp = temp;
+}
+
+// ZZ: map changed policy limits to the scaling index by binary search, the index itself stays as built at start
+static void zz_update_limits(struct zz_policy_dbs_info *dbs_info)
+{
+	if (unlikely(!dbs_info->freq_table_size))
+	    return;
+
+	dbs_info->max_scaling_freq_hard = zz_freq_floor_index(dbs_info, dbs_info->pol_max);
+	dbs_info->min_scaling_freq_hard = zz_freq_ceil_index(dbs_info, dbs_info->pol_min);
+	zz_update_soft_limit(dbs_info, dbs_info->soft_limit_cap);
+}
+
+// ZZ: frequency cap for the soft limit as requested by the actual state (0 = none), the lowest cap wins
+static inline unsigned int zz_get_soft_limit_cap(struct zz_policy_dbs_info *dbs_info, struct zz_dbs_tuners *zz_tuners)
+{
+	unsigned int cap = zz_get_thermal_cap(dbs_info, zz_tuners);
+
+	if (zz_tuners->idle && zz_tuners->idle_max_freq && (!cap || zz_tuners->idle_max_freq < cap))
+	    cap = zz_tuners->idle_max_freq;
 
-        /*
-         * ZZ: we have to take care about where we are in the frequency table. when using kernel sources without OC capability
-         * it might be that the first few indexes are containg no frequencies so a save index start point is needed.
-         */
-	calc_index = dbs_info->freq_table_size - dbs_info->max_scaling_freq_hard;			// ZZ: calculate the difference and use it as start point
+	return cap;
+}
 
-	if (calc_index == dbs_info->freq_table_size)							// ZZ: if we are at the end of the table
-		calc_index = calc_index - 1;								// ZZ: shift in range for order calculation below
+// ZZ: highest frequency this policy currently may run at
+static inline unsigned int zz_get_soft_max_freq(struct zz_policy_dbs_info *dbs_info, struct cpufreq_policy *policy)
+{
+	if (likely(dbs_info->freq_table_size))
+	    return min(policy->max, dbs_info->freq_index[dbs_info->max_scaling_freq_soft]);
 
-        // Yank: assert if CPU freq. table is in ascending or descending order
-	if (dbs_info->freq_table[calc_index].frequency > dbs_info->freq_table[calc_index+1].frequency) {
-		dbs_info->freq_table_desc = true;							// Yank: table is in descending order as expected, lowest freq at the bottom of the table
-		dbs_info->min_scaling_freq = i - 1;							// Yank: last valid frequency step (lowest frequency)
-		dbs_info->limit_table_start = dbs_info->max_scaling_freq_soft;				// ZZ: we should use the actual max scaling soft limit value as search start point
-        } else {
-		dbs_info->freq_table_desc = false;							// Yank: table is in ascending order, lowest freq at the top of the table
-		dbs_info->min_scaling_freq = 0;								// Yank: first valid frequency step (lowest frequency)
-		dbs_info->limit_table_start = dbs_info->min_scaling_freq_hard;				// ZZ: we should use the actual min scaling hard limit value as search start point
-		dbs_info->limit_table_end = dbs_info->pol_max;						// ZZ: end searching at highest frequency limit
-        }
+	return policy->max;
 }
 
 // Yank: return a valid value between min and max
@@ -158,33 +718,46 @@ static int validate_min_max(int val, int min, int max)
 	return min(max(val, min), max);
 }
 
-// ZZ: system table scaling mode with freq search optimizations and proportional frequency target option
-static inline int zz_get_next_freq(unsigned int curfreq, unsigned int updown, unsigned int load, struct cpufreq_policy *policy)
+/*
+ * ZZ: system table scaling mode with cached scaling index position and proportional frequency target option. the up
+ * threshold is the one of the actual frequency step, as resolved by the sampling path
+ */
+static inline int zz_get_next_freq(unsigned int curfreq, unsigned int updown, unsigned int load, unsigned int up_threshold,
+    struct cpufreq_policy *policy, struct zz_dbs_tuners *zz_tuners)
 {
 	struct policy_dbs_info *policy_dbs = policy->governor_data;
 	struct zz_policy_dbs_info *dbs_info = to_dbs_info(policy_dbs);
-	struct dbs_data *dbs_data = policy->governor_data;
-	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
 	int i = 0;
 	unsigned int prop_target = 0;									// ZZ: proportional freq
 	unsigned int zz_target = 0;									// ZZ: system table freq
 	unsigned int dead_band_freq = 0;								// ZZ: dead band freq
 	int smooth_up_steps = 0;									// Yank: smooth up steps
-	static int tmp_limit_table_start = 0;
-	static int tmp_max_scaling_freq_soft = 0;
-	static int tmp_limit_table_end = 0;
+	unsigned int fast_scaling_up = zz_tuners->fast_scaling_up;					// ZZ: static fast scaling as baseline...
+	unsigned int fast_scaling_down = zz_tuners->fast_scaling_down;
+	unsigned int path = ZZ_PATH_TABLE;								// ZZ: which way the target was found, for tracing
 
 	prop_target = dbs_info->pol_min + load * (dbs_info->pol_max - dbs_info->pol_min) / 100;		// ZZ: prepare proportional target freq whitout deadband (directly mapped to min->max load)
 
-	if (zz_tuners->scaling_proportional == 2)							// ZZ: mode '2' use proportional target frequencies only
-	    return prop_target;
+	if (zz_tuners->scaling_proportional == 2) {							// ZZ: mode '2' use proportional target frequencies only
+	    zz_target = prop_target;
+	    path = ZZ_PATH_PROPORTIONAL;
+	    goto out;
+	}
 
 	if (zz_tuners->scaling_proportional == 3) {							// ZZ: mode '3' use proportional target frequencies only and switch to pol_min in deadband range
 	    dead_band_freq = dbs_info->pol_max / 100 * load;						// ZZ: use old calculation to get deadband frequencies (=lower than pol_min)
 	    if (dead_band_freq > dbs_info->pol_min)							// ZZ: the load usually is too unsteady so we rarely would reach pol_min when load is low
-		return prop_target;									// ZZ: in fact it only will happen when load=0, so only return proportional frequencies if they
+		zz_target = prop_target;								// ZZ: in fact it only will happen when load=0, so only return proportional frequencies if they
 	    else											//     are out of deadband range and if we are in deadband range return min freq
-		return dbs_info->pol_min;								//     (thats a similar behaving as with old propotional freq calculation)
+		zz_target = dbs_info->pol_min;								//     (thats a similar behaving as with old propotional freq calculation)
+	    path = ZZ_PATH_PROPORTIONAL;
+	    goto out;
+	}
+
+	if (zz_tuners->scaling_proportional == 4 && dbs_info->opp_power_valid) {			// ZZ: mode '4' use lowest energy step providing the required capacity
+	    zz_target = zz_get_energy_freq(dbs_info, curfreq, load, up_threshold);
+	    path = ZZ_PATH_ENERGY;
+	    goto out;
 	}
 
 	if (load <= zz_tuners->smooth_up)								// Yank: consider smooth up
@@ -192,204 +765,996 @@ static inline int zz_get_next_freq(unsigned int curfreq, unsigned int updown, un
 	else
 	    smooth_up_steps = 1;									// Yank: load reached, move by two steps
 
-	// ZZ: first assign new limits...
-	tmp_limit_table_start = dbs_info->limit_table_start;
-	tmp_limit_table_end = dbs_info->limit_table_end;
-	tmp_max_scaling_freq_soft = dbs_info->max_scaling_freq_soft;
-
-	// ZZ: asc: min freq limit changed
-	if (!dbs_info->freq_table_desc && curfreq
-	    < dbs_info->freq_table[dbs_info->min_scaling_freq].frequency)				// ZZ: asc: but reset starting index if current freq is lower than soft/hard min limit otherwise we are
-	    tmp_limit_table_start = 0;									//     shifting out of range and proportional freq is used instead because freq can't be found by loop
-
-	// ZZ: asc: max freq limit changed
-	if (!dbs_info->freq_table_desc && curfreq
-	    > dbs_info->freq_table[dbs_info->max_scaling_freq_soft].frequency)				// ZZ: asc: but reset ending index if current freq is higher than soft/hard max limit otherwise we are
-	    tmp_limit_table_end = dbs_info->freq_table[dbs_info->freq_table_size].frequency;		//     shifting out of range and proportional freq is used instead because freq can't be found by loop
-
-	// ZZ: desc: max freq limit changed
-	if (dbs_info->freq_table_desc && curfreq
-	    > dbs_info->freq_table[dbs_info->limit_table_start].frequency)				// ZZ: desc: but reset starting index if current freq is higher than soft/hard max limit otherwise we are
-	    tmp_limit_table_start = 0;									//     shifting out of range and proportional freq is used instead because freq can't be found by loop
-
-	// ZZ: feq search loop with optimization
-	if (dbs_info->freq_table_desc) {
-	    for (i = tmp_limit_table_start; (likely(dbs_info->freq_table[i].frequency != tmp_limit_table_end)); i++) {
-		if (unlikely(curfreq == dbs_info->freq_table[i].frequency)) {				// Yank: we found where we currently are (i)
-		    if (updown == 1) {									// Yank: scale up, but don't go above softlimit
-			zz_target = min(dbs_info->freq_table[tmp_max_scaling_freq_soft].frequency,
-		        dbs_info->freq_table[validate_min_max(i - 1 - smooth_up_steps - zz_tuners->fast_scaling_up, 0, dbs_info->freq_table_size)].frequency);
-			if (zz_tuners->scaling_proportional == 1)					// ZZ: if proportional scaling is enabled
-			    return min(zz_target, prop_target);						// ZZ: check which freq is lower and return it
-			else
-			    return zz_target;								// ZZ: or return the found system table freq as usual
-		    } else {										// Yank: scale down, but don't go below min. freq.
-			zz_target = max(dbs_info->freq_table[dbs_info->min_scaling_freq].frequency,
-		        dbs_info->freq_table[validate_min_max(i + 1 + zz_tuners->fast_scaling_down, 0, dbs_info->freq_table_size)].frequency);
-			if (zz_tuners->scaling_proportional == 1)					// ZZ: if proportional scaling is enabled
-			    return min(zz_target, prop_target);						// ZZ: check which freq is lower and return it
-			else
-			    return zz_target;								// ZZ: or return the found system table freq as usual
-		    }
-		}
-	    }												// ZZ: this shouldn't happen but if the freq is not found in system table
-	    return prop_target;										//     fall back to proportional freq target to avoid returning 0
-	} else {
-	    for (i = tmp_limit_table_start; (likely(dbs_info->freq_table[i].frequency <= tmp_limit_table_end)); i++) {
-		if (unlikely(curfreq == dbs_info->freq_table[i].frequency)) {				// Yank: we found where we currently are (i)
-		    if (updown == 1) {									// Yank: scale up, but don't go above softlimit
-			zz_target = min(dbs_info->freq_table[tmp_max_scaling_freq_soft].frequency,
-			dbs_info->freq_table[validate_min_max(i + 1 + smooth_up_steps + zz_tuners->fast_scaling_up, 0, dbs_info->freq_table_size)].frequency);
-			if (zz_tuners->scaling_proportional == 1)					// ZZ: if proportional scaling is enabled
-			    return min(zz_target, prop_target);						// ZZ: check which freq is lower and return it
-			else
-			    return zz_target;								// ZZ: or return the found system table freq as usual
-		    } else {										// Yank: scale down, but don't go below min. freq.
-			zz_target = max(dbs_info->freq_table[dbs_info->min_scaling_freq].frequency,
-			dbs_info->freq_table[validate_min_max(i - 1 - zz_tuners->fast_scaling_down, 0, dbs_info->freq_table_size)].frequency);
-			if (zz_tuners->scaling_proportional == 1)					// ZZ: if proportional scaling is enabled
-			    return min(zz_target, prop_target);						// ZZ: check which freq is lower and return it
-			else
-			    return zz_target;								// ZZ: or return the found system table freq as usual
-		    }
-		}
-	    }												// ZZ: this shouldn't happen but if the freq is not found in system table
-	    return prop_target;										//     fall back to proportional freq target to avoid returning 0
+	if (zz_tuners->afs_up)										// ZZ: ...or the auto fast scaling levels of this policy
+	    fast_scaling_up = dbs_info->afs_scaling_up;
+
+	if (zz_tuners->afs_down)
+	    fast_scaling_down = dbs_info->afs_scaling_down;
+
+	i = zz_get_freq_index(dbs_info, curfreq);							// ZZ: where we currently are in the scaling index
+
+	if (unlikely(i < 0)) {										// ZZ: this shouldn't happen but if the freq is not found in system table
+	    zz_target = prop_target;									//     fall back to proportional freq target to avoid returning 0
+	    path = ZZ_PATH_FALLBACK;
+	    dbs_info->stats.table_fallbacks++;
+	    goto out;
 	}
+
+	if (updown == 1)										// Yank: scale up, but don't go above softlimit
+	    i = validate_min_max(i + 1 + smooth_up_steps + fast_scaling_up, dbs_info->min_scaling_freq_hard, dbs_info->max_scaling_freq_soft);
+	else												// Yank: scale down, but don't go below min. freq.
+	    i = validate_min_max(i - 1 - fast_scaling_down, dbs_info->min_scaling_freq_hard, dbs_info->freq_table_size - 1);
+
+	zz_target = dbs_info->freq_index[i];
+	dbs_info->cur_freq_index = i;									// ZZ: assume the driver sets what we request, verified at next lookup
+
+	if (zz_tuners->scaling_proportional == 1 && prop_target < zz_target) {				// ZZ: if proportional scaling is enabled check which freq is lower and return it
+	    zz_target = prop_target;									//     or return the found system table freq as usual
+	    path = ZZ_PATH_PROPORTIONAL;
+	}
+
+    out:
+	trace_zzmoove_next_freq(policy->cpu, curfreq, zz_target, updown, load, smooth_up_steps,
+	    updown == 1 ? fast_scaling_up : fast_scaling_down, path);
+	return zz_target;
 }
 
 /*
- * Every sampling_rate * sampling_up_factor we check, if current idle time is less than 20% (default)
- * then we try to increase frequency. Every sampling_rate * sampling_down_factor we check if current
- * idle time is more than 60% (default), then we try to decrease frequency
+ * ZZ: set the new frequency. if the driver supports it and it is enabled we switch with the fast switch callback of
+ * the driver, which skips the transition notifier chains and the waiting for the end of the transition. the switch
+ * is still issued from the dbs work, so it saves the transition overhead but not the latency of the work
  */
-static unsigned int zz_dbs_timer(struct cpufreq_policy *policy)
+static void zz_set_freq(struct cpufreq_policy *policy, unsigned int freq, unsigned int relation, bool fast_switch)
 {
-	struct policy_dbs_info *policy_dbs = policy->governor_data;
-	struct zz_policy_dbs_info *dbs_info = to_dbs_info(policy_dbs);
-	struct dbs_data *dbs_data = policy_dbs->dbs_data;
-	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
-	unsigned int load = dbs_update(policy);
-
-	// ZZ: save pol limits in gov data and evaluate scaling range if not done already at init or limits have changed
-	if (dbs_info->pol_min != policy->min || dbs_info->pol_max != policy->max || !dbs_info->scaling_init_eval_done) {
-	    dbs_info->pol_min = policy->min;
-	    dbs_info->pol_max = policy->max;
-	    evaluate_scaling_order_limit_range(policy);
+	if (!fast_switch || !policy->fast_switch_enabled) {
+	    __cpufreq_driver_target(policy, freq, relation);
+	    return;
 	}
 
-	/*
-	 * ZZ/Yank: Auto fast scaling mode
-	 * Switch to all 4 fast scaling modes depending on load gradient
-	 * the mode will start switching at given afs threshold load changes in both directions
-	 */
-	if (zz_tuners->afs_up       > 0) {
-	    if (load > dbs_info->zz_prev_load && load - dbs_info->zz_prev_load <= zz_tuners->afs_threshold1) {
-		zz_tuners->fast_scaling_up = 0;
-	    } else if (load - dbs_info->zz_prev_load <= zz_tuners->afs_threshold2) {
-		zz_tuners->fast_scaling_up = 1;
-	    } else if (load - dbs_info->zz_prev_load <= zz_tuners->afs_threshold3) {
-		zz_tuners->fast_scaling_up = 2;
-	    } else if (load - dbs_info->zz_prev_load <= zz_tuners->afs_threshold4) {
-		zz_tuners->fast_scaling_up = 3;
-	    } else {
-		zz_tuners->fast_scaling_up = 4;
-	    }
-	}
+	freq = clamp_val(freq, policy->min, policy->max);
 
-	if (zz_tuners->afs_down       > 0) {
-	  if (load < dbs_info->zz_prev_load && dbs_info->zz_prev_load - load <= zz_tuners->afs_threshold1) {
-		zz_tuners->fast_scaling_down = 0;
-	    } else if (dbs_info->zz_prev_load - load <= zz_tuners->afs_threshold2) {
-		zz_tuners->fast_scaling_down = 1;
-	    } else if (dbs_info->zz_prev_load - load <= zz_tuners->afs_threshold3) {
-		zz_tuners->fast_scaling_down = 2;
-	    } else if (dbs_info->zz_prev_load - load <= zz_tuners->afs_threshold4) {
-		zz_tuners->fast_scaling_down = 3;
-	    } else {
-		zz_tuners->fast_scaling_down = 4;
-	    }
-	}
+	if (freq == policy->cur)
+	    return;
 
-	/* if sampling_up_factor is active break out early */
-	if (++dbs_info->up_skip < zz_tuners->sampling_up_factor)
-		goto out;
+	freq = cpufreq_driver_fast_switch(policy, freq);
 
-	dbs_info->up_skip = 0;
+	if (freq == CPUFREQ_ENTRY_INVALID)
+	    return;
 
-	/* Check for frequency increase */
-	if (load > dbs_data->up_threshold) {
-		dbs_info->down_skip = 0;
+	policy->cur = freq;										// ZZ: no notifiers on the fast path so keep the bookkeeping here
+	trace_cpu_frequency(freq, smp_processor_id());
+}
 
-		/* if we are already at full speed then break out early */
-		if (dbs_info->requested_freq == policy->max)
-			goto out;
+/*
+ * ZZ: fast switching blocks the registration of transition notifiers system wide while enabled for any policy, so
+ * it is only enabled while the fast_switch tunable is set. the core enables it once per call, hence the check
+ */
+static void zz_fast_switch_enable(struct cpufreq_policy *policy, bool enable)
+{
+	if (enable && !policy->fast_switch_enabled)
+	    cpufreq_enable_fast_switch(policy);
+	else if (!enable)
+	    cpufreq_disable_fast_switch(policy);
+}
 
-		dbs_info->requested_freq = zz_get_next_freq(policy->cur, 1, load, policy);
+// ZZ: load of the sample 'age' samples before the last one saved in load history
+static inline unsigned int zz_load_history(struct zz_policy_dbs_info *dbs_info, unsigned int age)
+{
+	return dbs_info->load_history[(dbs_info->load_history_pos - 1 - age) & (ZZ_LOAD_HISTORY_SIZE - 1)];
+}
 
-		// ZZ: this is for proportional scaling mode only as zzmoove scaling delivers only frequencies which are 'in range'
-		if (dbs_info->requested_freq > policy->max)
-			dbs_info->requested_freq = policy->max;
+/*
+ * ZZ: predictive load model. the load is forecasted one sample ahead by double exponential smoothing (level weight 1/2,
+ * trend weight 1/4). in mode '2' the load history is additionally searched for a repeating pattern (frame rendering,
+ * audio buffers) and if one is found the load which followed one period ago is used as forecast. the higher one of
+ * actual and forecasted load is returned so we are already at the right step when the burst comes in
+ */
+static unsigned int zz_predict_load(struct zz_policy_dbs_info *dbs_info, unsigned int load, unsigned int mode)
+{
+	int prev_level = dbs_info->load_level;
+	int forecast;
+	unsigned int period, age, err;
+	unsigned int best_period = 0;
+	unsigned int best_err = ZZ_PREDICTION_PERIOD_TOLERANCE + 1;
 
-		__cpufreq_driver_target(policy, dbs_info->requested_freq, CPUFREQ_RELATION_H);
-		goto out;
+	dbs_info->load_history[dbs_info->load_history_pos] = load;
+	dbs_info->load_history_pos = (dbs_info->load_history_pos + 1) & (ZZ_LOAD_HISTORY_SIZE - 1);
+
+	if (dbs_info->load_history_cnt < ZZ_LOAD_HISTORY_SIZE)
+	    dbs_info->load_history_cnt++;
+
+	if (dbs_info->load_history_cnt == 1) {
+	    dbs_info->load_level = load << 8;
+	    dbs_info->load_trend = 0;
+	} else {
+	    dbs_info->load_level = ((int)(load << 8) + prev_level + dbs_info->load_trend) / 2;
+	    dbs_info->load_trend += (dbs_info->load_level - prev_level - dbs_info->load_trend) / 4;
 	}
 
-	/* if sampling_down_factor is active break out early */
-	if (++dbs_info->down_skip < zz_tuners->sampling_down_factor)
-		goto out;
+	forecast = (dbs_info->load_level + dbs_info->load_trend) / 256;
+
+	if (mode == 2) {
+	    // ZZ: compare the last period with the one before for all periods fitting twice into the history
+	    for (period = 2; period * 2 <= dbs_info->load_history_cnt; period++) {
+		for (age = 0, err = 0; age < period; age++)
+		    err += abs((int)zz_load_history(dbs_info, age) - (int)zz_load_history(dbs_info, age + period));
+		err /= period;
+		if (err < best_err) {
+		    best_err = err;
+		    best_period = period;
+		}
+	    }
 
-	dbs_info->down_skip = 0;
+	    if (best_period)
+		forecast = zz_load_history(dbs_info, best_period - 1);
+	}
 
-	/* Check for frequency decrease */
-	if (load < zz_tuners->down_threshold) {
-		dbs_info->up_skip = 0;
+	return max_t(int, load, clamp_val(forecast, 0, 100));
+}
 
-		 /* if we cannot reduce the frequency anymore, break out early */
-		if (policy->cur == policy->min)
-			goto out;
+/*
+ * ZZ: account time in state, estimated energy, work and load of this sample, reset all statistics first if requested.
+ * the load of a sample was measured over the period just ended, which ran at the freq before this sample
+ */
+static inline void zz_update_stats(struct zz_policy_dbs_info *dbs_info, u64 now, unsigned int cur_freq, unsigned int load)
+{
+	struct zz_policy_stats *stats = &dbs_info->stats;
+	unsigned int index;
+	u64 delta;
 
-		dbs_info->requested_freq = zz_get_next_freq(policy->cur, 0, load, policy);
+	if (unlikely(READ_ONCE(dbs_info->stats_reset))) {
+	    memset(stats, 0, sizeof(*stats));
+	    WRITE_ONCE(dbs_info->stats_reset, false);
+	}
 
-		__cpufreq_driver_target(policy,  dbs_info->requested_freq, CPUFREQ_RELATION_L);
+	if (likely(stats->last_update && dbs_info->freq_table_size)) {
+	    index = zz_freq_floor_index(dbs_info, cur_freq);
+	    delta = now - stats->last_update;
+	    stats->time_in_state[index] += delta;
+	    delta = div_u64(delta, NSEC_PER_USEC);
+	    stats->energy += (u64)dbs_info->opp_power[index] * delta;
+	    // ZZ: load in percent x freq in kHz x time in us gives cycles / 100000
+	    stats->work += div_u64((u64)load * cur_freq * delta, 100 * 1000);
 	}
 
-    out:
-	dbs_info->zz_prev_load = load;
-	return dbs_data->sampling_rate;
+	stats->last_update = now;
+	stats->load_hist[min_t(unsigned int, load / 10, ZZ_STATS_LOAD_BUCKETS - 1)]++;
 }
 
-/************************** sysfs interface ************************/
-
-static ssize_t store_sampling_down_factor(struct gov_attr_set *attr_set,
-		const char *buf, size_t count)
+// ZZ: add a record to the sample ring, lock free as the sampling path is the only writer
+static void zz_ring_write(struct zz_ring_header *ring, struct zz_policy_dbs_info *dbs_info, u64 now,
+	unsigned int load, unsigned int cur_freq, int direction, unsigned int interval,
+	const unsigned int *cpu_loads, unsigned int cpu_cnt)
 {
-	struct dbs_data *dbs_data = to_dbs_data(attr_set);
-	unsigned int input;
-	int ret;
-	ret = sscanf(buf, "%u", &input);
-
-	if (ret != 1 || input > MAX_SAMPLING_DOWN_FACTOR || input < 1)
-		return -EINVAL;
+	struct zz_ring_record *rec;
+	u32 head = dbs_info->ring_head;
+	unsigned int i;
+
+	// ZZ: the header is writable by the collector, so the head is kept here and the tail only used for the fill level
+	if (head - smp_load_acquire(&ring->tail) >= ZZ_RING_RECORDS) {
+	    WRITE_ONCE(ring->dropped, ring->dropped + 1);
+	    return;
+	}
 
-	dbs_data->sampling_down_factor = input;
-	return count;
+	rec = (struct zz_ring_record *)((char *)ring + ZZ_RING_HEADER_SIZE) + (head & (ZZ_RING_RECORDS - 1));
+	rec->time = now;
+	rec->cur_freq = cur_freq;
+	rec->requested_freq = dbs_info->requested_freq;
+	rec->interval = interval;
+	rec->up_skip = dbs_info->up_skip;
+	rec->down_skip = dbs_info->down_skip;
+	rec->load = load;
+	rec->prev_load = dbs_info->zz_prev_load;
+	rec->direction = direction;
+	rec->afs_scaling_up = dbs_info->afs_scaling_up;
+	rec->afs_scaling_down = dbs_info->afs_scaling_down;
+	rec->cpu_cnt = min_t(unsigned int, cpu_cnt, ZZ_RING_CPUS);
+
+	for (i = 0; i < ZZ_RING_CPUS; i++)
+		rec->cpu_load[i] = i < rec->cpu_cnt ? cpu_loads[i] : 0;
+
+	// ZZ: the record has to be complete before the collector sees the new head
+	dbs_info->ring_head = head + 1;
+	smp_store_release(&ring->head, head + 1);
 }
 
-static ssize_t store_sampling_up_factor(struct gov_attr_set *attr_set,
-		const char *buf, size_t count)
+// ZZ: account an up or down decision with the amount of scaling index steps taken
+static inline void zz_update_step_stats(struct zz_policy_dbs_info *dbs_info, unsigned int from_freq, unsigned int to_freq)
 {
-	struct dbs_data *dbs_data = to_dbs_data(attr_set);
-	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
-	unsigned int input;
-	int ret;
-	ret = sscanf(buf, "%u", &input);
+	unsigned int from, to;
 
-	if (ret != 1 || input > MAX_SAMPLING_UP_FACTOR || input < 1)
-		return -EINVAL;
+	if (unlikely(!dbs_info->freq_table_size))
+	    return;
 
-	zz_tuners->sampling_up_factor = input;
-	return count;
+	from = zz_freq_floor_index(dbs_info, from_freq);
+	to = zz_freq_floor_index(dbs_info, to_freq);
+
+	if (to >= from) {
+	    dbs_info->stats.up_decisions++;
+	    dbs_info->stats.up_step_hist[min_t(unsigned int, to - from, ZZ_STATS_STEP_BUCKETS - 1)]++;
+	} else {
+	    dbs_info->stats.down_decisions++;
+	    dbs_info->stats.down_step_hist[min_t(unsigned int, from - to, ZZ_STATS_STEP_BUCKETS - 1)]++;
+	}
+}
+
+/*
+ * ZZ: cross cluster coordination. a saturated policy (load above up threshold at its frequency ceiling) raises the
+ * floor of the sibling clusters in its table and releases it again when its load falls below down threshold. floors
+ * are held per cpu so no lock is needed, a floor is only released by the policy which raised it and as saturated
+ * policies raise their floors on every sample a floor released meanwhile by someone else is raised again. without
+ * governor tunables per policy all policies share one table, so each policy skips the entries of its own cpus and
+ * 'big cpu:freq little cpu:freq' lets each cluster raise the other one
+ */
+static DEFINE_PER_CPU(unsigned int, zz_coord_floor);
+
+// ZZ: release all sibling floors raised by this policy
+static void zz_coord_release(struct zz_policy_dbs_info *dbs_info)
+{
+	unsigned int i;
+
+	for (i = 0; i < dbs_info->coord_cnt; i++)
+		cmpxchg(&per_cpu(zz_coord_floor, dbs_info->coord[i].cpu), dbs_info->coord[i].freq, 0);
+
+	dbs_info->coord_cnt = 0;
+}
+
+static void zz_coord_update(struct zz_policy_dbs_info *dbs_info, struct cpufreq_policy *policy,
+	struct zz_dbs_tuners *zz_tuners, unsigned int load, unsigned int max_freq)
+{
+	unsigned int *floor;
+	unsigned int i, n, cur;
+
+	// ZZ: table changed, floors raised for the old one have to go
+	if (unlikely(dbs_info->coord_gen != zz_tuners->coord_gen)) {
+	    zz_coord_release(dbs_info);
+	    dbs_info->coord_gen = zz_tuners->coord_gen;
+	}
+
+	if (load > zz_tuners->up_threshold && policy->cur >= max_freq) {
+	    for (i = 0, n = 0; i < zz_tuners->coord_cnt; i++) {
+		if (cpumask_test_cpu(zz_tuners->coord[i].cpu, policy->related_cpus))
+		    continue;
+
+		floor = &per_cpu(zz_coord_floor, zz_tuners->coord[i].cpu);
+		cur = READ_ONCE(*floor);
+
+		// ZZ: don't lower a higher floor raised by another policy
+		if (cur < zz_tuners->coord[i].freq)
+		    cmpxchg(floor, cur, zz_tuners->coord[i].freq);
+
+		dbs_info->coord[n++] = zz_tuners->coord[i];
+	    }
+	    dbs_info->coord_cnt = n;
+	    return;
+	}
+
+	if (dbs_info->coord_cnt && load < zz_tuners->down_threshold)
+	    zz_coord_release(dbs_info);
+}
+
+/*
+ * ZZ: per cpu load. the governor core only delivers the max load of all cpus of the policy, so for load aggregation
+ * and the sample ring the load of each cpu is tracked here the same way the core does it. returns the amount of
+ * loads written, only valid if the loads were tracked in the previous sample as well
+ */
+static DEFINE_PER_CPU(u64, zz_prev_cpu_idle);
+static DEFINE_PER_CPU(u64, zz_prev_cpu_wall);
+static DEFINE_PER_CPU(u64, zz_prev_cpu_nice);
+
+static unsigned int zz_get_cpu_loads(struct cpufreq_policy *policy, struct zz_dbs_tuners *zz_tuners,
+	struct dbs_data *dbs_data, unsigned int *loads)
+{
+	unsigned int n = 0, cpu;
+	u64 idle, wall, nice, idle_delta, wall_delta;
+
+	for_each_cpu(cpu, policy->cpus) {
+		idle = get_cpu_idle_time(cpu, &wall, dbs_data->io_is_busy);
+		wall_delta = wall - per_cpu(zz_prev_cpu_wall, cpu);
+		idle_delta = idle - per_cpu(zz_prev_cpu_idle, cpu);
+		per_cpu(zz_prev_cpu_wall, cpu) = wall;
+		per_cpu(zz_prev_cpu_idle, cpu) = idle;
+
+		if (zz_tuners->ignore_nice_load) {
+		    nice = kcpustat_cpu(cpu).cpustat[CPUTIME_NICE];
+		    idle_delta += cputime_to_usecs(nice - per_cpu(zz_prev_cpu_nice, cpu));
+		    per_cpu(zz_prev_cpu_nice, cpu) = nice;
+		}
+
+		if (n < ZZ_AGGREGATION_MAX_CPUS)
+		    loads[n++] = wall_delta > idle_delta ? div64_u64((wall_delta - idle_delta) * 100, wall_delta) : 0;
+	}
+
+	return n;
+}
+
+/*
+ * ZZ: load aggregation of the per cpu loads:
+ * 1 = average weighted by load (idle cpus count less than in a plain average)
+ * 2 = load at the given percentile of all cpus
+ * 3 = max load, discounted if only one cpu is busy (load above down threshold)
+ */
+static unsigned int zz_aggregate_load(struct zz_dbs_tuners *zz_tuners, const unsigned int *cpu_loads,
+	unsigned int n, unsigned int max_load)
+{
+	unsigned int loads[ZZ_AGGREGATION_MAX_CPUS];
+	unsigned int busy = 0, top = 0;
+	unsigned int load, i, j;
+	u64 sum = 0, sum_sq = 0;
+
+	if (!n)
+	    return max_load;
+
+	for (i = 0; i < n; i++) {
+		load = cpu_loads[i];
+		sum += load;
+		sum_sq += load * load;
+		top = max(top, load);
+
+		if (load > zz_tuners->down_threshold)
+		    busy++;
+	}
+
+	switch (zz_tuners->load_aggregation) {
+	case 1:
+		return sum ? div64_u64(sum_sq, sum) : 0;
+	case 2:
+		// ZZ: insertion sort into a copy, there are only a few cpus per policy
+		for (i = 0; i < n; i++) {
+			load = cpu_loads[i];
+			for (j = i; j > 0 && loads[j - 1] > load; j--)
+				loads[j] = loads[j - 1];
+			loads[j] = load;
+		}
+		return loads[max_t(int, DIV_ROUND_UP(n * zz_tuners->load_aggregation_percentile, 100) - 1, 0)];
+	case 3:
+		if (busy == 1)
+		    return top * (100 - zz_tuners->load_aggregation_discount) / 100;
+		return top;
+	}
+
+	return max_load;
+}
+
+/*
+ * ZZ: iowait boost. the governor core counts iowait as idle, so tasks blocking on storage look like low load and the
+ * frequency goes down which slows down every completion. while samples are iowait heavy the boost floor starts at the
+ * actual frequency and goes up one step per sample up to the iowait boost frequency, otherwise it decays by one step
+ * per sample until it is below the min hard limit
+ */
+static DEFINE_PER_CPU(u64, zz_prev_iowait);
+static DEFINE_PER_CPU(u64, zz_prev_iowait_wall);
+
+// ZZ: highest iowait share in percent of all cpus of the policy since the last call
+static unsigned int zz_get_iowait_load(struct cpufreq_policy *policy)
+{
+	unsigned int iowait_load = 0;
+	u64 iowait, wall, iowait_delta, wall_delta;
+	unsigned int cpu;
+
+	for_each_cpu(cpu, policy->cpus) {
+		iowait = get_cpu_iowait_time_us(cpu, &wall);
+
+		// ZZ: no iowait accounting without NO_HZ
+		if (iowait == (u64)-1)
+		    continue;
+
+		iowait_delta = iowait - per_cpu(zz_prev_iowait, cpu);
+		wall_delta = wall - per_cpu(zz_prev_iowait_wall, cpu);
+		per_cpu(zz_prev_iowait, cpu) = iowait;
+		per_cpu(zz_prev_iowait_wall, cpu) = wall;
+
+		if (wall_delta && iowait_delta <= wall_delta)
+		    iowait_load = max_t(unsigned int, iowait_load, div64_u64(iowait_delta * 100, wall_delta));
+	}
+
+	return iowait_load;
+}
+
+static void zz_update_iowait_boost(struct zz_policy_dbs_info *dbs_info, struct zz_dbs_tuners *zz_tuners,
+	struct cpufreq_policy *policy)
+{
+	int i = -1;
+
+	if (!zz_tuners->iowait_boost || unlikely(!dbs_info->freq_table_size)) {
+	    dbs_info->iowait_boost_freq = 0;
+	    return;
+	}
+
+	if (dbs_info->iowait_boost_freq)
+	    i = zz_freq_floor_index(dbs_info, dbs_info->iowait_boost_freq);
+
+	if (zz_get_iowait_load(policy) >= ZZ_IOWAIT_BOOST_THRESHOLD) {
+	    if (i < 0)
+		i = zz_freq_floor_index(dbs_info, policy->cur);
+	    else
+		i++;
+
+	    i = min_t(int, i, zz_freq_floor_index(dbs_info, zz_tuners->iowait_boost));
+	    dbs_info->iowait_boost_freq = dbs_info->freq_index[i];
+	    return;
+	}
+
+	if (i > (int)dbs_info->min_scaling_freq_hard)
+	    dbs_info->iowait_boost_freq = dbs_info->freq_index[i - 1];
+	else
+	    dbs_info->iowait_boost_freq = 0;
+}
+
+// ZZ: lowest frequency this policy currently must run at (0 = none), never above the soft limit
+static inline unsigned int zz_get_floor_freq(struct zz_policy_dbs_info *dbs_info, struct zz_dbs_tuners *zz_tuners,
+	struct cpufreq_policy *policy)
+{
+	unsigned int floor_freq = 0;
+	unsigned int cpu;
+
+	if (zz_tuners->input_boost_freq && ktime_get_ns() < READ_ONCE(dbs_info->input_boost_until))
+	    floor_freq = zz_tuners->input_boost_freq;
+
+	for_each_cpu(cpu, policy->related_cpus)
+		floor_freq = max(floor_freq, READ_ONCE(per_cpu(zz_coord_floor, cpu)));
+
+	floor_freq = max(floor_freq, dbs_info->iowait_boost_freq);
+
+	if (!floor_freq)
+	    return 0;
+
+	return min(floor_freq, zz_get_soft_max_freq(dbs_info, policy));
+}
+
+/*
+ * ZZ: auto fast scaling level (0-4 = extra steps) for the load gradient from 'base' to 'load' in the scaling direction.
+ * this only depends on the loads and the afs thresholds so the same calculation is used for both directions and can
+ * be evaluated outside of the governor. an unchanged load or a change against the scaling direction selects no
+ * extra steps
+ */
+static inline unsigned int zz_get_afs_level(unsigned int load, unsigned int base, struct zz_dbs_tuners *zz_tuners)
+{
+	unsigned int gradient;
+
+	if (load <= base)
+	    return 0;
+
+	gradient = load - base;
+
+	if (gradient <= zz_tuners->afs_threshold1)
+	    return 0;
+	else if (gradient <= zz_tuners->afs_threshold2)
+	    return 1;
+	else if (gradient <= zz_tuners->afs_threshold3)
+	    return 2;
+	else if (gradient <= zz_tuners->afs_threshold4)
+	    return 3;
+
+	return 4;
+}
+
+/*
+ * ZZ: core parking. the sampling path only requests cores to be parked or brought back, the hotplug operations are
+ * done by one global work which holds no governor locks (taking a core down stops and starts the governor of its
+ * policy). cores of policies which are not managed anymore are brought back by the same work. the masks below are
+ * changed concurrently by sysfs stores, the sampling paths of all policies and the work, so they are only changed by
+ * atomic bit operations
+ */
+static struct cpumask zz_hotplug_allowed;		// ZZ: cores of policies with parking enabled
+static struct cpumask zz_hotplug_parked;		// ZZ: cores parked by us
+static struct cpumask zz_hotplug_up_mask;		// ZZ: parked cores requested to come back
+static struct cpumask zz_hotplug_down_mask;		// ZZ: cores requested to be parked
+
+static void zz_hotplug_fn(struct work_struct *work)
+{
+	unsigned int cpu;
+
+	for_each_cpu(cpu, &zz_hotplug_parked) {
+		// ZZ: someone else brought it back meanwhile
+		if (cpu_online(cpu)) {
+		    cpumask_clear_cpu(cpu, &zz_hotplug_parked);
+		    continue;
+		}
+
+		if ((cpumask_test_and_clear_cpu(cpu, &zz_hotplug_up_mask) || !cpumask_test_cpu(cpu, &zz_hotplug_allowed))
+		    && !cpu_up(cpu))
+		    cpumask_clear_cpu(cpu, &zz_hotplug_parked);
+	}
+
+	for_each_cpu(cpu, &zz_hotplug_down_mask) {
+		cpumask_clear_cpu(cpu, &zz_hotplug_down_mask);
+
+		if (!cpumask_test_cpu(cpu, &zz_hotplug_allowed) || !cpu_online(cpu))
+		    continue;
+
+		if (!cpu_down(cpu))
+		    cpumask_set_cpu(cpu, &zz_hotplug_parked);
+	}
+}
+
+static DECLARE_WORK(zz_hotplug_work, zz_hotplug_fn);
+
+// ZZ: allow or disallow parking cores of a policy, disallowed cores which are parked are brought back
+static void zz_hotplug_allow(struct cpufreq_policy *policy, bool allow)
+{
+	unsigned int cpu;
+
+	for_each_cpu(cpu, policy->related_cpus) {
+		if (allow) {
+		    cpumask_set_cpu(cpu, &zz_hotplug_allowed);
+		    continue;
+		}
+
+		cpumask_clear_cpu(cpu, &zz_hotplug_allowed);
+		cpumask_clear_cpu(cpu, &zz_hotplug_down_mask);
+	}
+
+	/*
+	 * ZZ: always run the work when disallowing, a core it is taking down right now is only marked as parked
+	 * afterwards and would stay down otherwise. the work runs again after the running one in that case
+	 */
+	if (!allow)
+	    queue_work(system_power_efficient_wq, &zz_hotplug_work);
+}
+
+/*
+ * ZZ: decide about parking cores with the usual thresholds. a core comes back after sampling up factor samples with
+ * load above up threshold at the highest allowed freq or more runnable tasks than online cores (system wide count,
+ * only available if built in), a core is parked after hotplug hysteresis samples with load of all cores below down
+ * threshold. the boot core of the policy is never parked and after each change both counts start over
+ */
+static void zz_hotplug_check(struct zz_policy_dbs_info *dbs_info, struct cpufreq_policy *policy,
+	struct zz_dbs_tuners *zz_tuners, unsigned int load)
+{
+	unsigned int max_freq = zz_get_soft_max_freq(dbs_info, policy);
+	bool more_tasks = false;
+	unsigned int cpu;
+
+	// ZZ: wait for requests of this policy which are still pending
+	if (!zz_tuners->hotplug || cpumask_intersects(&zz_hotplug_up_mask, policy->related_cpus)
+	    || cpumask_intersects(&zz_hotplug_down_mask, policy->related_cpus))
+	    return;
+
+#ifndef MODULE
+	more_tasks = nr_running() > num_online_cpus();
+#endif
+
+	if ((load > zz_tuners->up_threshold && policy->cur >= max_freq) || more_tasks) {
+	    dbs_info->hotplug_down_skip = 0;
+
+	    if (++dbs_info->hotplug_up_skip < zz_tuners->sampling_up_factor)
+		return;
+
+	    for_each_cpu(cpu, policy->related_cpus) {
+		if (cpumask_test_cpu(cpu, &zz_hotplug_parked) && !cpu_online(cpu)) {
+		    cpumask_set_cpu(cpu, &zz_hotplug_up_mask);
+		    queue_work(system_power_efficient_wq, &zz_hotplug_work);
+		    break;
+		}
+	    }
+
+	    dbs_info->hotplug_up_skip = 0;
+	    return;
+	}
+
+	dbs_info->hotplug_up_skip = 0;
+
+	if (load >= zz_tuners->down_threshold || cpumask_weight(policy->cpus) <= zz_tuners->hotplug_min_cpus) {
+	    dbs_info->hotplug_down_skip = 0;
+	    return;
+	}
+
+	if (++dbs_info->hotplug_down_skip < zz_tuners->hotplug_hysteresis)
+	    return;
+
+	// ZZ: park the last core which can be taken down
+	for (cpu = nr_cpu_ids; cpu-- > 0;) {
+		if (cpu != policy->cpu && cpumask_test_cpu(cpu, policy->cpus) && cpu_is_hotpluggable(cpu)) {
+		    cpumask_set_cpu(cpu, &zz_hotplug_down_mask);
+		    queue_work(system_power_efficient_wq, &zz_hotplug_work);
+		    break;
+		}
+	}
+
+	dbs_info->hotplug_down_skip = 0;
+}
+
+/*
+ * ZZ: next sampling period in adaptive sampling mode. the period is halved (down to min sampling rate) right away on
+ * big load changes or load close to up threshold, doubled per sample (up to the stretch factor) while load is stable
+ * and far below down threshold and otherwise it's the sampling rate
+ */
+static unsigned int zz_get_sample_interval(struct zz_policy_dbs_info *dbs_info, struct zz_dbs_tuners *zz_tuners,
+	struct dbs_data *dbs_data, unsigned int load, unsigned int interval)
+{
+	unsigned int gradient = abs((int)load - (int)dbs_info->zz_prev_load);
+
+	if (gradient >= ZZ_ADAPTIVE_GRADIENT || load + ZZ_ADAPTIVE_MARGIN >= zz_tuners->up_threshold)
+	    return max(dbs_data->sampling_rate / 2, dbs_data->min_sampling_rate);
+
+	if (gradient <= ZZ_ADAPTIVE_STABLE && load < zz_tuners->down_threshold / 2)
+	    return min(interval * 2, dbs_data->sampling_rate * zz_tuners->adaptive_sampling);
+
+	return dbs_data->sampling_rate;
+}
+
+/*
+ * ZZ: sampling factor check, true if this sample has to be skipped. with adaptive sampling samples count by their
+ * length in percent of the sampling rate (unit 100) so the factors keep their meaning in wall clock time, a factor
+ * of 1 still means a decision on every sample
+ */
+static inline bool zz_factor_skip(unsigned int *skip, unsigned int factor, unsigned int weight, unsigned int unit)
+{
+	if (factor <= 1 || *skip + weight >= factor * unit)
+	    return false;
+
+	*skip += weight;
+	return true;
+}
+
+/*
+ * ZZ: transition hysteresis, true if a transition in the given direction has to be refused. a reversal of the last
+ * transition is refused within a window of the transition latency (multiplied as it doesn't include the settling) or
+ * twice the average time after which reversals got requested, whatever is longer but never above the tunable max.
+ * so loads oscillating around the thresholds stop flapping between steps and a real change is followed after the
+ * window at the latest
+ */
+static bool zz_hysteresis_hold(struct zz_policy_dbs_info *dbs_info, struct zz_dbs_tuners *zz_tuners,
+	struct cpufreq_policy *policy, int dir, u64 now)
+{
+	u64 max_window = (u64)zz_tuners->transition_hysteresis * NSEC_PER_MSEC;
+	u64 latency = 0;
+	u64 since, window;
+
+	if (!max_window || !dbs_info->last_transition_dir || dir == dbs_info->last_transition_dir)
+	    return false;
+
+	since = now - dbs_info->last_transition_time;
+
+	// ZZ: only the first request after a transition tells how fast the load oscillates
+	if (!dbs_info->reversal_seen) {
+	    dbs_info->reversal_period = (dbs_info->reversal_period * 3 + min(since, max_window)) / 4;
+	    dbs_info->reversal_seen = true;
+	}
+
+	if (policy->cpuinfo.transition_latency != CPUFREQ_ETERNAL)
+	    latency = policy->cpuinfo.transition_latency;
+
+	window = min(max(latency * ZZ_HYSTERESIS_LATENCY_MULT, dbs_info->reversal_period * 2), max_window);
+
+	if (since >= window)
+	    return false;
+
+	dbs_info->stats.hysteresis_suppressed++;
+	return true;
+}
+
+/*
+ * Every sampling_rate * sampling_up_factor we check, if current idle time is less than 20% (default)
+ * then we try to increase frequency. Every sampling_rate * sampling_down_factor we check if current
+ * idle time is more than 60% (default), then we try to decrease frequency
+ */
+static unsigned int zz_dbs_timer(struct cpufreq_policy *policy)
+{
+	struct policy_dbs_info *policy_dbs = policy->governor_data;
+	struct zz_policy_dbs_info *dbs_info = to_dbs_info(policy_dbs);
+	struct dbs_data *dbs_data = policy_dbs->dbs_data;
+	struct zz_dbs_tuners *zz_tuners;
+	unsigned int load = dbs_update(policy);
+	unsigned int max_load = load;									// ZZ: max load of all cpus, before aggregation
+	unsigned int cur_freq = policy->cur;								// ZZ: freq before this sample, for tracing
+	int direction = 0;										// ZZ: decision of this sample, for tracing
+	bool full_period = true;									// ZZ: sample ends a sampling period (always outside of event mode)
+	u64 elapsed;											// ZZ: time in us covered by the load of this sample in event mode
+	unsigned int pred_load;										// ZZ: actual or predicted load used for decisions
+	unsigned int floor_freq;									// ZZ: frequency floor (input boost)
+	unsigned int max_freq;										// ZZ: frequency ceiling (policy max or soft limit)
+	unsigned int soft_cap;										// ZZ: actual soft limit cap
+	unsigned int new_freq = 0;									// ZZ: frequency to set after this sample (0 = none)
+	unsigned int relation = CPUFREQ_RELATION_L;							// ZZ: relation for setting the new frequency
+	bool fast_switch;										// ZZ: fast switch setting of this sample
+	char thermal_zone[THERMAL_NAME_LENGTH];								// ZZ: thermal zone to read after this sample
+	unsigned int interval;										// ZZ: length of the sampling period
+	unsigned int skip_weight = 1, skip_unit = 1;							// ZZ: sampling factor accounting of this sample
+	unsigned int up_threshold, down_threshold;							// ZZ: thresholds at the actual frequency
+	unsigned int delay;										// ZZ: time until next sample
+	struct zz_ring_header *ring = smp_load_acquire(&dbs_info->ring);				// ZZ: sample ring (NULL = not opened yet)
+	unsigned int cpu_loads[ZZ_AGGREGATION_MAX_CPUS];						// ZZ: per cpu loads of this sample
+	unsigned int cpu_cnt = 0;									// ZZ: amount of valid per cpu loads
+	int i;
+
+	/*
+	 * ZZ: all decisions of this sample use the tunables snapshot taken here. the transition itself can sleep so it
+	 * is done after leaving the read side, with the settings picked up from the same snapshot
+	 */
+	rcu_read_lock();
+	zz_tuners = &rcu_dereference(((struct zz_dbs_tuners *)dbs_data->tuners)->snap)->tuners;
+
+	if (zz_tuners->adaptive_sampling && dbs_info->sample_interval)
+	    interval = dbs_info->sample_interval;
+	else
+	    interval = dbs_data->sampling_rate;
+
+	// ZZ: per cpu loads are only valid if the previous sample tracked them as well
+	if (zz_tuners->load_aggregation || ring) {
+	    cpu_cnt = zz_get_cpu_loads(policy, zz_tuners, dbs_data, cpu_loads);
+	    if (!dbs_info->cpu_loads_tracked)
+		cpu_cnt = 0;
+	}
+
+	dbs_info->cpu_loads_tracked = zz_tuners->load_aggregation || ring;
+
+	if (zz_tuners->load_aggregation)
+	    load = zz_aggregate_load(zz_tuners, cpu_loads, cpu_cnt, load);
+
+	// ZZ: save pol limits in gov data and map them to the scaling index if they have changed
+	if (unlikely(dbs_info->pol_min != policy->min || dbs_info->pol_max != policy->max)) {
+	    dbs_info->pol_min = policy->min;
+	    dbs_info->pol_max = policy->max;
+	    zz_update_limits(dbs_info);
+	}
+
+	// ZZ: power table changed, evaluate efficient steps again
+	if (unlikely(dbs_info->opp_power_gen != zz_tuners->opp_power_gen))
+	    zz_evaluate_opp_power(dbs_info, zz_tuners);
+
+	// ZZ: threshold table changed, map it again
+	if (unlikely(dbs_info->opp_thresholds_gen != zz_tuners->opp_thresholds_gen))
+	    zz_evaluate_opp_thresholds(dbs_info, zz_tuners);
+
+	// ZZ: thresholds of the actual frequency step or the global ones if the step has none
+	up_threshold = zz_tuners->up_threshold;
+	down_threshold = zz_tuners->down_threshold;
+	i = zz_get_freq_index(dbs_info, policy->cur);
+
+	if (i >= 0 && dbs_info->opp_up_threshold[i]) {
+	    up_threshold = dbs_info->opp_up_threshold[i];
+	    down_threshold = dbs_info->opp_down_threshold[i];
+	}
+
+	// ZZ: soft limit cap changed, evaluate soft limit again
+	soft_cap = zz_get_soft_limit_cap(dbs_info, zz_tuners);
+
+	if (unlikely(dbs_info->soft_limit_cap != soft_cap))
+	    zz_update_soft_limit(dbs_info, soft_cap);
+
+	max_freq = zz_get_soft_max_freq(dbs_info, policy);
+
+	zz_update_stats(dbs_info, policy_dbs->last_sample_time, cur_freq, load);
+
+	/*
+	 * ZZ: scheduler event mode. the governor core calls us from the scheduler utilization update hooks, so with a rate
+	 * limit below sampling_rate we are evaluated at the first scheduler event after the rate limit has passed. within a
+	 * sampling period only immediate up scaling is done (not delayed by sampling up factor), all other decisions, the
+	 * sampling factors and auto fast scaling work on the average load of the full sampling period as usual. the load
+	 * of each sample covers the time since the sample before, so the average is weighted by that time
+	 */
+	if (zz_tuners->sched_event_rate_limit) {
+	    elapsed = dbs_info->event_last_time ? div_u64(policy_dbs->last_sample_time - dbs_info->event_last_time, NSEC_PER_USEC) : 0;
+	    elapsed = max_t(u64, elapsed, 1);
+	    dbs_info->event_last_time = policy_dbs->last_sample_time;
+	    dbs_info->event_load_sum += load * elapsed;
+	    dbs_info->event_max_load_sum += max_load * elapsed;
+	    dbs_info->event_time += elapsed;
+
+	    if (policy_dbs->last_sample_time - dbs_info->last_full_sample_time < (u64)interval * NSEC_PER_USEC) {
+		full_period = false;
+	    } else {
+		load = div64_u64(dbs_info->event_load_sum, dbs_info->event_time);
+		max_load = div64_u64(dbs_info->event_max_load_sum, dbs_info->event_time);
+		dbs_info->event_load_sum = 0;
+		dbs_info->event_max_load_sum = 0;
+		dbs_info->event_time = 0;
+		dbs_info->last_full_sample_time = policy_dbs->last_sample_time;
+	    }
+	}
+
+	/*
+	 * ZZ/Yank: Auto fast scaling mode
+	 * Switch to all 4 fast scaling modes depending on load gradient
+	 * the mode will start switching at given afs threshold load changes in both directions
+	 * levels are held per policy so clusters sharing the tuners don't influence each other
+	 * the gradient is taken between full sampling periods only
+	 */
+	if (full_period && zz_tuners->afs_up > 0)
+	    dbs_info->afs_scaling_up = zz_get_afs_level(load, dbs_info->zz_prev_load, zz_tuners);
+
+	if (full_period && zz_tuners->afs_down > 0)
+	    dbs_info->afs_scaling_down = zz_get_afs_level(dbs_info->zz_prev_load, load, zz_tuners);
+
+	// ZZ: the iowait boost ramps by one step per sampling period and its iowait share is measured over whole periods
+	if (full_period)
+	    zz_update_iowait_boost(dbs_info, zz_tuners, policy);
+
+	// ZZ: go to the frequency floor right away if we are below it, down scaling from there happens by the usual steps
+	floor_freq = zz_get_floor_freq(dbs_info, zz_tuners, policy);
+
+	if (floor_freq > policy->cur) {
+	    dbs_info->requested_freq = new_freq = floor_freq;
+	    relation = CPUFREQ_RELATION_L;
+	    direction = 1;
+	    goto out;
+	}
+
+	/*
+	 * ZZ: scale down towards the frequency ceiling if we are above it (soft limit lowered), like usual down scaling
+	 * by one step plus fast scaling per sample so throttling is done as smooth as the scaling itself
+	 */
+	if (policy->cur > max_freq) {
+	    i = zz_get_freq_index(dbs_info, policy->cur);
+	    new_freq = max_freq;
+
+	    if (i > 0)
+		new_freq = max(dbs_info->freq_index[max(i - 1 - (int)zz_tuners->fast_scaling_down, 0)], max_freq);
+
+	    dbs_info->requested_freq = new_freq;
+	    relation = CPUFREQ_RELATION_H;
+	    direction = -1;
+	    goto out;
+	}
+
+	// ZZ: scheduler event mode, immediate up scaling on the load of this sample within a sampling period
+	if (!full_period) {
+	    if (load > up_threshold && dbs_info->requested_freq != max_freq
+		&& !zz_hysteresis_hold(dbs_info, zz_tuners, policy, 1, policy_dbs->last_sample_time)) {
+		dbs_info->requested_freq = new_freq = min_t(unsigned int, zz_get_next_freq(policy->cur, 1, load, up_threshold, policy, zz_tuners), max_freq);
+		relation = CPUFREQ_RELATION_H;
+		direction = 1;
+	    }
+	    goto out;
+	}
+
+	// ZZ: use predicted load for decisions if enabled
+	if (zz_tuners->load_prediction)
+	    pred_load = zz_predict_load(dbs_info, load, zz_tuners->load_prediction);
+	else
+	    pred_load = load;
+
+	// ZZ: parking needs all cores below down threshold, so it goes by the max load and not the aggregated one
+	zz_hotplug_check(dbs_info, policy, zz_tuners, max_load);
+	zz_coord_update(dbs_info, policy, zz_tuners, pred_load, max_freq);
+
+	// ZZ: weight this sample by the period it covered and set the period up to the next one
+	if (zz_tuners->adaptive_sampling) {
+	    skip_weight = interval * 100 / dbs_data->sampling_rate;
+	    skip_unit = 100;
+	    dbs_info->sample_interval = zz_get_sample_interval(dbs_info, zz_tuners, dbs_data, pred_load, interval);
+	}
+
+	/* if sampling_up_factor is active break out early */
+	if (zz_factor_skip(&dbs_info->up_skip, zz_tuners->sampling_up_factor, skip_weight, skip_unit)) {
+		dbs_info->stats.up_suppressed++;
+		goto out;
+	}
+
+	dbs_info->up_skip = 0;
+
+	/* Check for frequency increase */
+	if (pred_load > up_threshold) {
+		dbs_info->down_skip = 0;
+
+		/* if we are already at full speed then break out early */
+		if (dbs_info->requested_freq == max_freq)
+			goto out;
+
+		if (zz_hysteresis_hold(dbs_info, zz_tuners, policy, 1, policy_dbs->last_sample_time))
+			goto out;
+
+		dbs_info->requested_freq = zz_get_next_freq(policy->cur, 1, pred_load, up_threshold, policy, zz_tuners);
+
+		// ZZ: this is for proportional scaling mode only as zzmoove scaling delivers only frequencies which are 'in range'
+		if (dbs_info->requested_freq > max_freq)
+			dbs_info->requested_freq = max_freq;
+
+		new_freq = dbs_info->requested_freq;
+		relation = CPUFREQ_RELATION_H;
+		direction = 1;
+		goto out;
+	}
+
+	/* if sampling_down_factor is active break out early */
+	if (zz_factor_skip(&dbs_info->down_skip, zz_tuners->sampling_down_factor, skip_weight, skip_unit)) {
+		dbs_info->stats.down_suppressed++;
+		goto out;
+	}
+
+	dbs_info->down_skip = 0;
+
+	/* Check for frequency decrease */
+	if (pred_load < down_threshold) {
+		dbs_info->up_skip = 0;
+
+		 /* if we cannot reduce the frequency anymore, break out early */
+		if (policy->cur == policy->min || policy->cur <= floor_freq)
+			goto out;
+
+		if (zz_hysteresis_hold(dbs_info, zz_tuners, policy, -1, policy_dbs->last_sample_time))
+			goto out;
+
+		dbs_info->requested_freq = max_t(unsigned int, zz_get_next_freq(policy->cur, 0, pred_load, up_threshold, policy, zz_tuners), floor_freq);
+
+		new_freq = dbs_info->requested_freq;
+		relation = CPUFREQ_RELATION_L;
+		direction = -1;
+	}
+
+    out:
+	if (new_freq && new_freq != cur_freq) {
+	    dbs_info->last_transition_time = policy_dbs->last_sample_time;
+	    dbs_info->last_transition_dir = new_freq > cur_freq ? 1 : -1;
+	    dbs_info->reversal_seen = false;
+	}
+
+	trace_zzmoove_sample(policy->cpu, load, dbs_info->zz_prev_load, cur_freq, dbs_info->requested_freq, direction,
+	    dbs_info->afs_scaling_up, dbs_info->afs_scaling_down, dbs_info->up_skip, dbs_info->down_skip);
+
+	if (ring)
+	    zz_ring_write(ring, dbs_info, policy_dbs->last_sample_time, load, cur_freq, direction, interval,
+		cpu_loads, cpu_cnt);
+
+	if (full_period)
+	    dbs_info->zz_prev_load = load;
+
+	if (zz_tuners->adaptive_sampling && dbs_info->sample_interval)
+	    interval = dbs_info->sample_interval;
+
+	/*
+	 * ZZ: the core takes the previous load instead of the measured one if a period was longer than twice the
+	 * sampling rate times the rate multiplier (idle wakeup). scale the multiplier with the stretched period like
+	 * ondemand does with its down factor, otherwise every other stretched sample would report the low load of
+	 * the previous one and a burst after a stretched period would be ignored for another whole period
+	 */
+	policy_dbs->rate_mult = max(DIV_ROUND_UP(interval, dbs_data->sampling_rate), 1U);
+
+	if (zz_tuners->sched_event_rate_limit)
+	    delay = min(zz_tuners->sched_event_rate_limit, interval);
+	else
+	    delay = interval;
+
+	fast_switch = zz_tuners->fast_switch;
+	thermal_zone[0] = '\0';
+	if (zz_tuners->thermal_trip_cnt)
+	    strlcpy(thermal_zone, zz_tuners->thermal_zone, THERMAL_NAME_LENGTH);
+	rcu_read_unlock();
+
+	if (thermal_zone[0])
+	    zz_thermal_poll(dbs_info, thermal_zone, policy_dbs->last_sample_time);
+
+	if (new_freq) {
+	    zz_set_freq(policy, new_freq, relation, fast_switch);
+	    zz_update_step_stats(dbs_info, cur_freq, new_freq);
+	}
+
+	return delay;
+}
+
+/************************** sysfs interface ************************/
+
+static ssize_t store_sampling_down_factor(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	unsigned int input;
+	int ret;
+	ret = sscanf(buf, "%u", &input);
+
+	if (ret != 1 || input > MAX_SAMPLING_DOWN_FACTOR || input < 1)
+		return -EINVAL;
+
+	dbs_data->sampling_down_factor = input;
+	return zz_publish_tuners(dbs_data) ?: count;
+}
+
+static ssize_t store_sampling_up_factor(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+	ret = sscanf(buf, "%u", &input);
+
+	if (ret != 1 || input > MAX_SAMPLING_UP_FACTOR || input < 1)
+		return -EINVAL;
+
+	zz_tuners->sampling_up_factor = input;
+	return zz_publish_tuners(dbs_data) ?: count;
 }
 
 static ssize_t store_up_threshold(struct gov_attr_set *attr_set,
@@ -401,58 +1766,1148 @@ static ssize_t store_up_threshold(struct gov_attr_set *attr_set,
 	int ret;
 	ret = sscanf(buf, "%u", &input);
 
-	if (ret != 1 || input > 100 || input <= zz_tuners->down_threshold)
-		return -EINVAL;
+	if (ret != 1 || input > 100 || input <= zz_tuners->down_threshold)
+		return -EINVAL;
+
+	dbs_data->up_threshold = input;
+	return zz_publish_tuners(dbs_data) ?: count;
+}
+
+static ssize_t store_down_threshold(struct gov_attr_set *attr_set, const char *buf,
+		size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+	ret = sscanf(buf, "%u", &input);
+
+	/* cannot be lower than 1 otherwise freq will not fall */
+	if (ret != 1 || input < 1 || input > 100 ||
+			input >= dbs_data->up_threshold)
+		return -EINVAL;
+
+	zz_tuners->down_threshold = input;
+	return zz_publish_tuners(dbs_data) ?: count;
+}
+
+static ssize_t store_ignore_nice_load(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+	if (ret != 1)
+		return -EINVAL;
+
+	if (input > 1)
+		input = 1;
+
+	if (input == dbs_data->ignore_nice_load) /* nothing to do */
+		return count;
+
+	dbs_data->ignore_nice_load = input;
+
+	ret = zz_publish_tuners(dbs_data);
+	if (ret)
+	    return ret;
+
+	/* we need to re-evaluate prev_cpu_idle */
+	gov_update_cpu_data(dbs_data);
+
+	return count;
+}
+
+// ZZ: tunable -> possible values: range from 1 to 100, if not set default is 75
+static ssize_t store_smooth_up(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+	if (ret != 1 || input > 100 || input < 1)
+	    return -EINVAL;
+
+	zz_tuners->smooth_up = input;
+
+	return zz_publish_tuners(dbs_data) ?: count;
+}
+
+/*
+ * ZZ: tunable scaling proportinal -> possible values: 0 to disable,
+ * 1 to enable comparision between proportional and optimized freq,
+ * 2 to enable propotional freq usage only
+ * 3 to enable propotional freq usage only but with dead brand range
+ * to avoid not reaching of pol min freq,
+ * 4 to enable energy aware freq selection (needs opp_power table,
+ * system table scaling is used as long as it is not set)
+ * if not set default is 0
+ */
+static ssize_t store_scaling_proportional(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+
+	if (ret != 1 || input < 0 || input > 4)
+	    return -EINVAL;
+
+	zz_tuners->scaling_proportional = input;
+
+	return zz_publish_tuners(dbs_data) ?: count;
+}
+
+/*
+ * Yank: tunable -> possible values 1-4 to enable fast upscaling (value 1-4 = steps)
+ */
+static ssize_t store_fast_scaling_up(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+
+	if (ret != 1 || input > 4 || input < 0)
+	    return -EINVAL;
+
+	zz_tuners->fast_scaling_up = input;
+	zz_tuners->afs_up = 0;
+
+	return zz_publish_tuners(dbs_data) ?: count;
+}
+
+/*
+ * Yank: tunable -> possible values 1-4 to enable fast downscaling (value 1-4 = steps)
+ */
+static ssize_t store_fast_scaling_down(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+
+	if (ret != 1 || input > 4 || input < 0)
+	    return -EINVAL;
+
+	zz_tuners->fast_scaling_down = input;
+	zz_tuners->afs_down = 0;
+
+	return zz_publish_tuners(dbs_data) ?: count;
+}
+
+/*
+ * ZZ: tunable -> possible values 1 to enable auto fast scaling (insane scaling)
+ * for upscaling and 0 to disable auto fast scaling for upscaling. auto levels
+ * are held per policy, fast_scaling_up stays untouched and is used again
+ * as soon as auto fast scaling gets disabled
+ */
+static ssize_t store_afs_up(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+
+	if (ret != 1 || input > 1 || input < 0)
+	    return -EINVAL;
+
+	zz_tuners->afs_up = input;
+
+	return zz_publish_tuners(dbs_data) ?: count;
+}
+
+/*
+ * ZZ: tunable -> possible values 1 to enable auto fast scaling (insane scaling)
+ * for downscaling and 0 to disable auto fast scaling for downscaling. auto levels
+ * are held per policy, fast_scaling_down stays untouched and is used again
+ * as soon as auto fast scaling gets disabled
+ */
+static ssize_t store_afs_down(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+
+	if (ret != 1 || input > 1 || input < 0)
+	    return -EINVAL;
+
+	zz_tuners->afs_down = input;
+
+	return zz_publish_tuners(dbs_data) ?: count;
+}
+
+// ZZ: afs tunable -> possible values from 0 to 100
+#define store_afs_threshold(name)					\
+static ssize_t store_afs_threshold##name(struct gov_attr_set *attr_set,	\
+		const char *buf, size_t count)				\
+{									\
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);		\
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;		\
+	unsigned int input;						\
+	int ret;							\
+									\
+	ret = sscanf(buf, "%u", &input);				\
+									\
+	if (ret != 1 || input > 100 || input < 0)			\
+	    return -EINVAL;						\
+									\
+	zz_tuners->afs_threshold##name = input;				\
+									\
+	return zz_publish_tuners(dbs_data) ?: count;			\
+}									\
+
+/*
+ * ZZ: tunable -> possible values 0 to disable scheduler event mode or rate limit
+ * in us (min_sampling_rate to 1 second) for evaluating scheduler events between
+ * samples to react on load bursts without waiting for the next sampling period
+ */
+static ssize_t store_sched_event_rate_limit(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct policy_dbs_info *policy_dbs;
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+
+	if (ret != 1 || input > USEC_PER_SEC || (input && input < dbs_data->min_sampling_rate))
+	    return -EINVAL;
+
+	zz_tuners->sched_event_rate_limit = input;
+
+	ret = zz_publish_tuners(dbs_data);
+	if (ret)
+	    return ret;
+
+	// ZZ: start over with a fresh sampling period on all policies
+	list_for_each_entry(policy_dbs, &attr_set->policy_list, list) {
+		mutex_lock(&policy_dbs->timer_mutex);
+		to_dbs_info(policy_dbs)->event_load_sum = 0;
+		to_dbs_info(policy_dbs)->event_max_load_sum = 0;
+		to_dbs_info(policy_dbs)->event_time = 0;
+		to_dbs_info(policy_dbs)->event_last_time = 0;
+		to_dbs_info(policy_dbs)->last_full_sample_time = 0;
+		gov_update_sample_delay(policy_dbs, 0);
+		mutex_unlock(&policy_dbs->timer_mutex);
+	}
+
+	return count;
+}
+
+/*
+ * ZZ: tunable -> possible values 1 to use fast frequency switching if the
+ * driver supports it and 0 to always use the regular transition path. while
+ * set no transition notifiers can be registered (-EBUSY) in the whole system
+ */
+static ssize_t store_fast_switch(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct policy_dbs_info *policy_dbs;
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+
+	if (ret != 1 || input > 1)
+	    return -EINVAL;
+
+	zz_tuners->fast_switch = input;
+
+	ret = zz_publish_tuners(dbs_data);
+	if (ret)
+	    return ret;
+
+	/*
+	 * ZZ: switching it on and off needs the policy lock. the core holds it while it waits for a running store on
+	 * governor exit, so don't wait for it here. a policy which is busy right now keeps its state, which is safe as
+	 * the sampling path checks the tunable as well, and the write can simply be repeated
+	 */
+	list_for_each_entry(policy_dbs, &attr_set->policy_list, list) {
+		if (!down_write_trylock(&policy_dbs->policy->rwsem)) {
+		    ret = -EBUSY;
+		    continue;
+		}
+
+		mutex_lock(&policy_dbs->timer_mutex);
+		zz_fast_switch_enable(policy_dbs->policy, input);
+		mutex_unlock(&policy_dbs->timer_mutex);
+		up_write(&policy_dbs->policy->rwsem);
+	}
+
+	return ret ?: count;
+}
+
+/*
+ * ZZ: tunable -> possible values 0 to disable load prediction, 1 to use a load
+ * forecast from smoothed load level and trend and 2 to additionally detect
+ * periodic load patterns for the forecast
+ */
+static ssize_t store_load_prediction(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+
+	if (ret != 1 || input > 2)
+	    return -EINVAL;
+
+	zz_tuners->load_prediction = input;
+
+	return zz_publish_tuners(dbs_data) ?: count;
+}
+
+// ZZ: parse a list of whitespace separated tuples of 'fields' values like 'a:b', returns amount of tuples or -EINVAL
+static int zz_parse_tuples(const char *buf, unsigned int *vals, unsigned int fields, unsigned int max_tuples)
+{
+	unsigned int tuples = 0;
+	unsigned int field;
+	int n;
+
+	while (*(buf = skip_spaces(buf))) {
+		if (tuples == max_tuples)
+		    return -EINVAL;
+
+		for (field = 0; field < fields; field++) {
+			if (field && *buf++ != ':')
+			    return -EINVAL;
+			if (sscanf(buf, "%u%n", &vals[tuples * fields + field], &n) != 1)
+			    return -EINVAL;
+			buf += n;
+		}
+
+		if (*buf && !isspace(*buf))
+		    return -EINVAL;
+
+		tuples++;
+	}
+
+	return tuples;
+}
+
+/*
+ * ZZ: tunable -> power table for energy aware scaling as list of 'freq:power'
+ * entries (power in any unit but the same for all entries, eg. from the
+ * platform energy model), write an empty line to clear the table
+ */
+static ssize_t store_opp_power(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	struct zz_opp_power_table *tbl = NULL, *old;
+	unsigned int vals[MAX_FREQ_TABLE_SIZE * 2];
+	int i, ret;
+
+	ret = zz_parse_tuples(buf, vals, 2, MAX_FREQ_TABLE_SIZE);
+
+	if (ret < 0)
+	    return ret;
+
+	for (i = 0; i < ret; i++) {
+		if (!vals[i * 2] || !vals[i * 2 + 1])
+		    return -EINVAL;
+	}
+
+	if (ret) {
+	    tbl = kmalloc(sizeof(*tbl) + ret * sizeof(tbl->entry[0]), GFP_KERNEL);
+	    if (!tbl)
+		return -ENOMEM;
+
+	    for (i = 0; i < ret; i++) {
+		tbl->entry[i].freq = vals[i * 2];
+		tbl->entry[i].power = vals[i * 2 + 1];
+	    }
+	    tbl->cnt = ret;
+	}
+
+	old = rcu_dereference_protected(zz_tuners->opp_power, true);
+	rcu_assign_pointer(zz_tuners->opp_power, tbl);
+	zz_tuners->opp_power_gen++;
+
+	// ZZ: on failure the old table is back in place, the new one may have been seen by show already
+	ret = zz_publish_tuners(dbs_data);
+	if (ret)
+	    old = tbl;
+
+	if (old)
+	    kfree_rcu(old, rcu);
+
+	return ret ?: count;
+}
+
+static ssize_t show_opp_power(struct gov_attr_set *attr_set, char *buf)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	struct zz_opp_power_table *tbl;
+	ssize_t len = 0;
+	unsigned int i;
+
+	rcu_read_lock();
+	tbl = rcu_dereference(zz_tuners->opp_power);
+
+	for (i = 0; tbl && i < tbl->cnt; i++)
+		len += scnprintf(buf + len, PAGE_SIZE - len, "%u:%u ",
+			tbl->entry[i].freq, tbl->entry[i].power);
+
+	rcu_read_unlock();
+
+	len += scnprintf(buf + len, PAGE_SIZE - len, "\n");
+	return len;
+}
+
+/*
+ * ZZ: tunable -> thresholds per frequency step as list of 'freq:up:down'
+ * entries (same ranges as the global thresholds), steps without an entry
+ * use the global thresholds, write an empty line to clear the table
+ */
+static ssize_t store_opp_thresholds(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	struct zz_opp_threshold_table *tbl = NULL, *old;
+	unsigned int vals[MAX_FREQ_TABLE_SIZE * 3];
+	int i, ret;
+
+	ret = zz_parse_tuples(buf, vals, 3, MAX_FREQ_TABLE_SIZE);
+
+	if (ret < 0)
+	    return ret;
+
+	for (i = 0; i < ret; i++) {
+		if (!vals[i * 3] || vals[i * 3 + 1] > 100 || vals[i * 3 + 2] < 1 || vals[i * 3 + 2] >= vals[i * 3 + 1])
+		    return -EINVAL;
+	}
+
+	if (ret) {
+	    tbl = kmalloc(sizeof(*tbl) + ret * sizeof(tbl->entry[0]), GFP_KERNEL);
+	    if (!tbl)
+		return -ENOMEM;
+
+	    for (i = 0; i < ret; i++) {
+		tbl->entry[i].freq = vals[i * 3];
+		tbl->entry[i].up = vals[i * 3 + 1];
+		tbl->entry[i].down = vals[i * 3 + 2];
+	    }
+	    tbl->cnt = ret;
+	}
+
+	old = rcu_dereference_protected(zz_tuners->opp_thresholds, true);
+	rcu_assign_pointer(zz_tuners->opp_thresholds, tbl);
+	zz_tuners->opp_thresholds_gen++;
+
+	// ZZ: on failure the old table is back in place, the new one may have been seen by show already
+	ret = zz_publish_tuners(dbs_data);
+	if (ret)
+	    old = tbl;
+
+	if (old)
+	    kfree_rcu(old, rcu);
+
+	return ret ?: count;
+}
+
+static ssize_t show_opp_thresholds(struct gov_attr_set *attr_set, char *buf)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	struct zz_opp_threshold_table *tbl;
+	ssize_t len = 0;
+	unsigned int i;
+
+	rcu_read_lock();
+	tbl = rcu_dereference(zz_tuners->opp_thresholds);
+
+	for (i = 0; tbl && i < tbl->cnt; i++)
+		len += scnprintf(buf + len, PAGE_SIZE - len, "%u:%u:%u ", tbl->entry[i].freq,
+			tbl->entry[i].up, tbl->entry[i].down);
+
+	rcu_read_unlock();
+
+	len += scnprintf(buf + len, PAGE_SIZE - len, "\n");
+	return len;
+}
+
+/*
+ * ZZ: tunable -> possible values 0 to disable input boost or frequency in kHz
+ * the policy is raised to at input events (touch, keys)
+ */
+static ssize_t store_input_boost_freq(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+
+	if (ret != 1)
+	    return -EINVAL;
+
+	zz_tuners->input_boost_freq = input;
+
+	return zz_publish_tuners(dbs_data) ?: count;
+}
+
+/*
+ * ZZ: tunable -> possible values 0 to disable iowait boost or max frequency
+ * in kHz the floor is ramped up to while samples are iowait heavy
+ */
+static ssize_t store_iowait_boost(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+
+	if (ret != 1)
+	    return -EINVAL;
+
+	zz_tuners->iowait_boost = input;
+
+	return zz_publish_tuners(dbs_data) ?: count;
+}
+
+// ZZ: tunable -> possible values from 1 to 5000 ms for keeping the input boost frequency as floor
+static ssize_t store_input_boost_duration(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+
+	if (ret != 1 || input < 1 || input > MAX_INPUT_BOOST_DURATION)
+	    return -EINVAL;
+
+	zz_tuners->input_boost_duration = input;
+
+	return zz_publish_tuners(dbs_data) ?: count;
+}
+
+/*
+ * ZZ: tunable -> possible values 0 to disable adaptive sampling or max stretch
+ * factor of sampling rate (1 to 10) for stable low load, on load changes the
+ * sampling period goes down to half of sampling rate
+ */
+static ssize_t store_adaptive_sampling(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+
+	if (ret != 1 || input > MAX_ADAPTIVE_SAMPLING)
+	    return -EINVAL;
+
+	zz_tuners->adaptive_sampling = input;
+
+	return zz_publish_tuners(dbs_data) ?: count;
+}
+
+/*
+ * ZZ: tunable -> possible values 0 to disable transition hysteresis or max
+ * window in ms (1 to 1000) within which reversals of the last transition
+ * are refused
+ */
+static ssize_t store_transition_hysteresis(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+
+	if (ret != 1 || input > MAX_TRANSITION_HYSTERESIS)
+	    return -EINVAL;
+
+	zz_tuners->transition_hysteresis = input;
+
+	return zz_publish_tuners(dbs_data) ?: count;
+}
+
+/*
+ * ZZ: tunable -> possible values 0 for max load of all cpus in the policy,
+ * 1 for average weighted by load, 2 for load at the given percentile, 3 for
+ * max load discounted if only one cpu is busy
+ */
+static ssize_t store_load_aggregation(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+
+	if (ret != 1 || input > 3)
+	    return -EINVAL;
+
+	zz_tuners->load_aggregation = input;
+
+	return zz_publish_tuners(dbs_data) ?: count;
+}
+
+// ZZ: tunable -> possible values from 1 to 100, percentile of the cpu loads used in load aggregation mode 2
+static ssize_t store_load_aggregation_percentile(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+
+	if (ret != 1 || input < 1 || input > 100)
+	    return -EINVAL;
+
+	zz_tuners->load_aggregation_percentile = input;
+
+	return zz_publish_tuners(dbs_data) ?: count;
+}
+
+// ZZ: tunable -> possible values from 0 to 100, discount in percent of the load of a single busy cpu in load aggregation mode 3
+static ssize_t store_load_aggregation_discount(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+
+	if (ret != 1 || input > 100)
+	    return -EINVAL;
+
+	zz_tuners->load_aggregation_discount = input;
+
+	return zz_publish_tuners(dbs_data) ?: count;
+}
+
+// ZZ: tunable -> possible values 0 to disable, 1 to enable parking cores at low load
+static ssize_t store_hotplug(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct policy_dbs_info *policy_dbs;
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+
+	if (ret != 1 || input > 1)
+	    return -EINVAL;
+
+	zz_tuners->hotplug = input;
+
+	ret = zz_publish_tuners(dbs_data);
+	if (ret)
+	    return ret;
+
+	list_for_each_entry(policy_dbs, &attr_set->policy_list, list)
+		zz_hotplug_allow(policy_dbs->policy, input);
 
-	dbs_data->up_threshold = input;
 	return count;
 }
 
-static ssize_t store_down_threshold(struct gov_attr_set *attr_set, const char *buf,
-		size_t count)
+// ZZ: tunable -> possible values from 1 to amount of cores, minimal amount of online cores per policy
+static ssize_t store_hotplug_min_cpus(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+
+	if (ret != 1 || input < 1 || input > nr_cpu_ids)
+	    return -EINVAL;
+
+	zz_tuners->hotplug_min_cpus = input;
+
+	return zz_publish_tuners(dbs_data) ?: count;
+}
+
+// ZZ: tunable -> possible values from 1 to 1000, amount of low load samples in a row before a core is parked
+static ssize_t store_hotplug_hysteresis(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	unsigned int input;
+	int ret;
+
+	ret = sscanf(buf, "%u", &input);
+
+	if (ret != 1 || input < 1 || input > MAX_HOTPLUG_HYSTERESIS)
+	    return -EINVAL;
+
+	zz_tuners->hotplug_hysteresis = input;
+
+	return zz_publish_tuners(dbs_data) ?: count;
+}
+
+/************************** profiles ************************/
+
+// ZZ: profile keys with the range of valid values (sampling rate range is checked against min sampling rate)
+static const struct zz_profile_key {
+	const char *name;
+	size_t offset;
+	unsigned int min;
+	unsigned int max;
+} zz_profile_keys[] = {
+	{ "sampling_rate",		offsetof(struct zz_profile, sampling_rate),		0, UINT_MAX },
+	{ "up_threshold",		offsetof(struct zz_profile, up_threshold),		1, 100 },
+	{ "down_threshold",		offsetof(struct zz_profile, down_threshold),		1, 100 },
+	{ "sampling_up_factor",		offsetof(struct zz_profile, sampling_up_factor),	1, MAX_SAMPLING_UP_FACTOR },
+	{ "sampling_down_factor",	offsetof(struct zz_profile, sampling_down_factor),	1, MAX_SAMPLING_DOWN_FACTOR },
+	{ "smooth_up",			offsetof(struct zz_profile, smooth_up),			1, 100 },
+	{ "scaling_proportional",	offsetof(struct zz_profile, scaling_proportional),	0, 4 },
+	{ "fast_scaling_up",		offsetof(struct zz_profile, fast_scaling_up),		0, 4 },
+	{ "fast_scaling_down",		offsetof(struct zz_profile, fast_scaling_down),		0, 4 },
+	{ "afs_up",			offsetof(struct zz_profile, afs_up),			0, 1 },
+	{ "afs_down",			offsetof(struct zz_profile, afs_down),			0, 1 },
+	{ "afs_threshold1",		offsetof(struct zz_profile, afs_threshold1),		0, 100 },
+	{ "afs_threshold2",		offsetof(struct zz_profile, afs_threshold2),		0, 100 },
+	{ "afs_threshold3",		offsetof(struct zz_profile, afs_threshold3),		0, 100 },
+	{ "afs_threshold4",		offsetof(struct zz_profile, afs_threshold4),		0, 100 },
+};
+
+#define zz_profile_val(prof, key)	(*(unsigned int *)((char *)(prof) + (key)->offset))
+
+// ZZ: built-in profiles, sampling rate is kept as set by the governor core
+static const struct zz_profile zz_default_profiles[] = {
+	{ .name = "battery", .up_threshold = 90, .down_threshold = 55, .sampling_up_factor = 2,
+	  .sampling_down_factor = 1, .smooth_up = 100, .afs_threshold1 = DEF_AFS_THRESHOLD1,
+	  .afs_threshold2 = DEF_AFS_THRESHOLD2, .afs_threshold3 = DEF_AFS_THRESHOLD3, .afs_threshold4 = DEF_AFS_THRESHOLD4 },
+	{ .name = "balanced", .up_threshold = DEF_FREQUENCY_UP_THRESHOLD, .down_threshold = DEF_FREQUENCY_DOWN_THRESHOLD,
+	  .sampling_up_factor = DEF_SAMPLING_UP_FACTOR, .sampling_down_factor = DEF_SAMPLING_DOWN_FACTOR,
+	  .smooth_up = DEF_SMOOTH_UP, .scaling_proportional = DEF_SCALING_PROPORTIONAL,
+	  .fast_scaling_up = DEF_FAST_SCALING_UP, .fast_scaling_down = DEF_FAST_SCALING_DOWN,
+	  .afs_up = DEF_AFS_UP, .afs_down = DEF_AFS_DOWN, .afs_threshold1 = DEF_AFS_THRESHOLD1,
+	  .afs_threshold2 = DEF_AFS_THRESHOLD2, .afs_threshold3 = DEF_AFS_THRESHOLD3, .afs_threshold4 = DEF_AFS_THRESHOLD4 },
+	{ .name = "performance", .up_threshold = 60, .down_threshold = 30, .sampling_up_factor = 1,
+	  .sampling_down_factor = 3, .smooth_up = 60, .fast_scaling_up = 1, .afs_up = 1,
+	  .afs_threshold1 = DEF_AFS_THRESHOLD1, .afs_threshold2 = DEF_AFS_THRESHOLD2,
+	  .afs_threshold3 = DEF_AFS_THRESHOLD3, .afs_threshold4 = DEF_AFS_THRESHOLD4 },
+};
+
+// ZZ: save the actual tunables into a profile
+static void zz_profile_save(struct dbs_data *dbs_data, struct zz_profile *prof)
+{
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+
+	prof->sampling_rate = dbs_data->sampling_rate;
+	prof->up_threshold = dbs_data->up_threshold;
+	prof->down_threshold = zz_tuners->down_threshold;
+	prof->sampling_up_factor = zz_tuners->sampling_up_factor;
+	prof->sampling_down_factor = dbs_data->sampling_down_factor;
+	prof->smooth_up = zz_tuners->smooth_up;
+	prof->scaling_proportional = zz_tuners->scaling_proportional;
+	prof->fast_scaling_up = zz_tuners->fast_scaling_up;
+	prof->fast_scaling_down = zz_tuners->fast_scaling_down;
+	prof->afs_up = zz_tuners->afs_up;
+	prof->afs_down = zz_tuners->afs_down;
+	prof->afs_threshold1 = zz_tuners->afs_threshold1;
+	prof->afs_threshold2 = zz_tuners->afs_threshold2;
+	prof->afs_threshold3 = zz_tuners->afs_threshold3;
+	prof->afs_threshold4 = zz_tuners->afs_threshold4;
+}
+
+// ZZ: check a complete profile, so cross checks don't depend on any write order
+static int zz_profile_validate(struct dbs_data *dbs_data, struct zz_profile *prof)
+{
+	const struct zz_profile_key *key;
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(zz_profile_keys); i++) {
+		key = &zz_profile_keys[i];
+		if (zz_profile_val(prof, key) < key->min || zz_profile_val(prof, key) > key->max)
+		    return -EINVAL;
+	}
+
+	if (prof->sampling_rate && prof->sampling_rate < dbs_data->min_sampling_rate)
+	    return -EINVAL;
+
+	if (prof->down_threshold >= prof->up_threshold)
+	    return -EINVAL;
+
+	return 0;
+}
+
+/*
+ * ZZ: apply a profile. all values go out in one tunables snapshot, so no sample ever sees a mix of old and new values
+ */
+static int zz_profile_apply(struct dbs_data *dbs_data, struct zz_profile *prof)
+{
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	struct policy_dbs_info *policy_dbs;
+	bool rate_changed = prof->sampling_rate && prof->sampling_rate != dbs_data->sampling_rate;
+	unsigned int rate = dbs_data->sampling_rate;
+	int ret;
+
+	if (prof->sampling_rate)
+	    dbs_data->sampling_rate = prof->sampling_rate;
+	dbs_data->up_threshold = prof->up_threshold;
+	zz_tuners->down_threshold = prof->down_threshold;
+	zz_tuners->sampling_up_factor = prof->sampling_up_factor;
+	dbs_data->sampling_down_factor = prof->sampling_down_factor;
+	zz_tuners->smooth_up = prof->smooth_up;
+	zz_tuners->scaling_proportional = prof->scaling_proportional;
+	zz_tuners->fast_scaling_up = prof->fast_scaling_up;
+	zz_tuners->fast_scaling_down = prof->fast_scaling_down;
+	zz_tuners->afs_up = prof->afs_up;
+	zz_tuners->afs_down = prof->afs_down;
+	zz_tuners->afs_threshold1 = prof->afs_threshold1;
+	zz_tuners->afs_threshold2 = prof->afs_threshold2;
+	zz_tuners->afs_threshold3 = prof->afs_threshold3;
+	zz_tuners->afs_threshold4 = prof->afs_threshold4;
+
+	// ZZ: the sampling rate is not part of the snapshot, so it's not rolled back by a failed publish
+	ret = zz_publish_tuners(dbs_data);
+	if (ret) {
+	    dbs_data->sampling_rate = rate;
+	    return ret;
+	}
+
+	if (!rate_changed)
+	    return 0;
+
+	// ZZ: take the new sampling rate into account right away like the common sampling rate tunable does
+	list_for_each_entry(policy_dbs, &dbs_data->attr_set.policy_list, list) {
+		mutex_lock(&policy_dbs->timer_mutex);
+		gov_update_sample_delay(policy_dbs, 0);
+		mutex_unlock(&policy_dbs->timer_mutex);
+	}
+
+	return 0;
+}
+
+// ZZ: profile slot with the given name or -1 if there is none
+static int zz_profile_find(struct zz_tuners_ext *ext, const char *name)
+{
+	unsigned int i;
+
+	for (i = 0; i < ext->profile_cnt; i++) {
+		if (!strcmp(ext->profiles[i].name, name))
+		    return i;
+	}
+
+	return -1;
+}
+
+/*
+ * ZZ: handle 'name [key=value ...]' writes. given values change the profile (which is created from the actual tunables
+ * if it doesn't exist yet), the whole profile is validated before it is stored and if requested loaded
+ */
+static ssize_t zz_profile_store(struct gov_attr_set *attr_set, const char *buf, size_t count, bool load)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_tuners_ext *ext = to_tuners_ext(dbs_data);
+	const struct zz_profile_key *key;
+	struct zz_profile prof;
+	char *str, *cur, *token, *val;
+	bool has_values = false;
+	unsigned int i, input;
+	int slot, ret = -EINVAL;
+
+	str = kstrndup(buf, count, GFP_KERNEL);
+	if (!str)
+	    return -ENOMEM;
+
+	cur = str;
+
+	do {
+		token = strsep(&cur, " \t\n");
+	} while (token && !*token);
+
+	if (!token || strlen(token) >= ZZ_PROFILE_NAME_LEN || strchr(token, '='))
+	    goto out;
+
+	slot = zz_profile_find(ext, token);
+
+	if (slot >= 0)
+	    prof = ext->profiles[slot];
+	else
+	    zz_profile_save(dbs_data, &prof);
+
+	strlcpy(prof.name, token, ZZ_PROFILE_NAME_LEN);
+
+	while ((token = strsep(&cur, " \t\n"))) {
+		if (!*token)
+		    continue;
+
+		val = strchr(token, '=');
+		if (!val)
+		    goto out;
+		*val++ = '\0';
+
+		for (i = 0; i < ARRAY_SIZE(zz_profile_keys); i++) {
+			if (!strcmp(zz_profile_keys[i].name, token))
+			    break;
+		}
+
+		if (i == ARRAY_SIZE(zz_profile_keys) || kstrtouint(val, 10, &input))
+		    goto out;
+
+		key = &zz_profile_keys[i];
+		zz_profile_val(&prof, key) = input;
+		has_values = true;
+	}
+
+	// ZZ: loading a profile which doesn't exist is an error, defining one from the actual tunables is not
+	if (load && slot < 0 && !has_values)
+	    goto out;
+
+	// ZZ: a name alone written to profiles saves the actual tunables, also over an existing profile
+	if (!load && !has_values)
+	    zz_profile_save(dbs_data, &prof);
+
+	ret = zz_profile_validate(dbs_data, &prof);
+	if (ret)
+	    goto out;
+
+	if (slot < 0 && ext->profile_cnt == ZZ_MAX_PROFILES) {
+	    ret = -ENOSPC;
+	    goto out;
+	}
+
+	// ZZ: the profile is only stored if loading it worked
+	if (load) {
+	    ret = zz_profile_apply(dbs_data, &prof);
+	    if (ret)
+		goto out;
+	}
+
+	if (slot < 0)
+	    slot = ext->profile_cnt++;
+
+	ext->profiles[slot] = prof;
+
+	if (load)
+	    ext->profile_active = slot;
+
+	ret = count;
+out:
+	kfree(str);
+	return ret;
+}
+
+/*
+ * ZZ: tunable -> name of profile to load, 'name key=value ...' changes or
+ * creates the profile with the given values and loads it in one go. shows
+ * the loaded profile or 'custom' if tunables were changed afterwards
+ */
+static ssize_t store_profile(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	return zz_profile_store(attr_set, buf, count, true);
+}
+
+static ssize_t show_profile(struct gov_attr_set *attr_set, char *buf)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_tuners_ext *ext = to_tuners_ext(dbs_data);
+	struct zz_profile *active;
+	struct zz_profile prof;
+	unsigned int i;
+
+	if (ext->profile_active < 0)
+	    return sprintf(buf, "custom\n");
+
+	active = &ext->profiles[ext->profile_active];
+	zz_profile_save(dbs_data, &prof);
+
+	if (!active->sampling_rate)
+	    prof.sampling_rate = 0;
+
+	for (i = 0; i < ARRAY_SIZE(zz_profile_keys); i++) {
+		if (zz_profile_val(&prof, &zz_profile_keys[i]) != zz_profile_val(active, &zz_profile_keys[i]))
+		    return sprintf(buf, "custom\n");
+	}
+
+	return sprintf(buf, "%s\n", active->name);
+}
+
+/*
+ * ZZ: tunable -> 'name key=value ...' changes or creates a profile without
+ * loading it, 'name' alone saves the actual tunables as profile. shows all
+ * profiles one per line
+ */
+static ssize_t store_profiles(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
+{
+	return zz_profile_store(attr_set, buf, count, false);
+}
+
+static ssize_t show_profiles(struct gov_attr_set *attr_set, char *buf)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_tuners_ext *ext = to_tuners_ext(dbs_data);
+	struct zz_profile *prof;
+	ssize_t len = 0;
+	unsigned int i, j;
+
+	for (i = 0; i < ext->profile_cnt; i++) {
+		prof = &ext->profiles[i];
+		len += scnprintf(buf + len, PAGE_SIZE - len, "%s", prof->name);
+		for (j = 0; j < ARRAY_SIZE(zz_profile_keys); j++)
+			len += scnprintf(buf + len, PAGE_SIZE - len, " %s=%u",
+				zz_profile_keys[j].name, zz_profile_val(prof, &zz_profile_keys[j]));
+		len += scnprintf(buf + len, PAGE_SIZE - len, "\n");
+	}
+
+	return len;
+}
+
+/************************** profiles end ************************/
+
+/************************** idle state ************************/
+
+/*
+ * ZZ: enter or leave the idle state. entering loads the idle profile (if there is one) after saving the actual tunables,
+ * leaving restores them. the idle soft limit is taken into account by the sampling path. sampling needs no change for
+ * idle cpus as the governor core samples from the scheduler hooks, so a cpu in NO_HZ idle is never woken up for it.
+ * the update lock of the attribute set must be held
+ */
+static int zz_idle_set(struct dbs_data *dbs_data, bool idle)
+{
+	struct zz_tuners_ext *ext = to_tuners_ext(dbs_data);
+	struct zz_dbs_tuners *zz_tuners = &ext->tuners;
+	struct zz_profile saved;
+	int slot, ret;
+
+	if (zz_tuners->idle == idle)
+	    return 0;
+
+	zz_tuners->idle = idle;
+
+	if (idle) {
+	    slot = zz_profile_find(ext, zz_tuners->idle_profile);
+
+	    if (slot < 0) {
+		ret = zz_publish_tuners(dbs_data);
+		if (!ret)
+		    ext->idle_profile_loaded = false;
+		return ret;
+	    }
+
+	    zz_profile_save(dbs_data, &saved);
+	    ret = zz_profile_apply(dbs_data, &ext->profiles[slot]);
+	    if (ret)
+		return ret;
+
+	    ext->idle_saved = saved;
+	    ext->idle_saved_active = ext->profile_active;
+	    ext->profile_active = slot;
+	    ext->idle_profile_loaded = true;
+	    return 0;
+	}
+
+	if (!ext->idle_profile_loaded)
+	    return zz_publish_tuners(dbs_data);
+
+	ret = zz_profile_apply(dbs_data, &ext->idle_saved);
+	if (ret)
+	    return ret;
+
+	ext->idle_profile_loaded = false;
+	ext->profile_active = ext->idle_saved_active;
+	return 0;
+}
+
+// ZZ: tunable -> possible values 0 to leave, 1 to enter idle state (also set on display blank events if available)
+static ssize_t store_idle(struct gov_attr_set *attr_set,
+		const char *buf, size_t count)
 {
 	struct dbs_data *dbs_data = to_dbs_data(attr_set);
-	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
 	unsigned int input;
 	int ret;
+
 	ret = sscanf(buf, "%u", &input);
 
-	/* cannot be lower than 1 otherwise freq will not fall */
-	if (ret != 1 || input < 1 || input > 100 ||
-			input >= dbs_data->up_threshold)
-		return -EINVAL;
+	if (ret != 1 || input > 1)
+	    return -EINVAL;
 
-	zz_tuners->down_threshold = input;
-	return count;
+	return zz_idle_set(dbs_data, input) ?: count;
 }
 
-static ssize_t store_ignore_nice_load(struct gov_attr_set *attr_set,
+// ZZ: tunable -> name of the profile to load in idle state, empty for keeping the tunables as they are
+static ssize_t store_idle_profile(struct gov_attr_set *attr_set,
 		const char *buf, size_t count)
 {
 	struct dbs_data *dbs_data = to_dbs_data(attr_set);
-	unsigned int input;
-	int ret;
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	char name[ZZ_PROFILE_NAME_LEN];
 
-	ret = sscanf(buf, "%u", &input);
-	if (ret != 1)
-		return -EINVAL;
+	if (sscanf(buf, "%15s", name) != 1)
+	    name[0] = '\0';
 
-	if (input > 1)
-		input = 1;
+	if (name[0] && zz_profile_find(to_tuners_ext(dbs_data), name) < 0)
+	    return -EINVAL;
 
-	if (input == dbs_data->ignore_nice_load) /* nothing to do */
-		return count;
+	strlcpy(zz_tuners->idle_profile, name, ZZ_PROFILE_NAME_LEN);
 
-	dbs_data->ignore_nice_load = input;
+	return zz_publish_tuners(dbs_data) ?: count;
+}
 
-	/* we need to re-evaluate prev_cpu_idle */
-	gov_update_cpu_data(dbs_data);
+static ssize_t show_idle_profile(struct gov_attr_set *attr_set, char *buf)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
 
-	return count;
+	return sprintf(buf, "%s\n", zz_tuners->idle_profile);
 }
 
-// ZZ: tunable -> possible values: range from 1 to 100, if not set default is 75
-static ssize_t store_smooth_up(struct gov_attr_set *attr_set,
+// ZZ: tunable -> max frequency in idle state as soft limit, 0 to disable
+static ssize_t store_idle_max_freq(struct gov_attr_set *attr_set,
 		const char *buf, size_t count)
 {
 	struct dbs_data *dbs_data = to_dbs_data(attr_set);
@@ -461,89 +2916,153 @@ static ssize_t store_smooth_up(struct gov_attr_set *attr_set,
 	int ret;
 
 	ret = sscanf(buf, "%u", &input);
-	if (ret != 1 || input > 100 || input < 1)
+
+	if (ret != 1)
 	    return -EINVAL;
 
-	zz_tuners->smooth_up = input;
+	zz_tuners->idle_max_freq = input;
 
-	return count;
+	return zz_publish_tuners(dbs_data) ?: count;
 }
 
-/*
- * ZZ: tunable scaling proportinal -> possible values: 0 to disable,
- * 1 to enable comparision between proportional and optimized freq,
- * 2 to enable propotional freq usage only
- * 3 to enable propotional freq usage only but with dead brand range
- * to avoid not reaching of pol min freq,
- * if not set default is 0
- */
-static ssize_t store_scaling_proportional(struct gov_attr_set *attr_set,
-		const char *buf, size_t count)
+#ifdef CONFIG_FB
+static bool zz_display_off;
+
+// ZZ: bring all tunable sets in line with the display state
+static void zz_idle_fn(struct work_struct *work)
 {
-	struct dbs_data *dbs_data = to_dbs_data(attr_set);
-	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
-	unsigned int input;
-	int ret;
+	struct zz_policy_dbs_info *dbs_info;
+	struct dbs_data *dbs_data;
+
+	mutex_lock(&zz_policy_list_lock);
+	list_for_each_entry(dbs_info, &zz_policy_list, zz_list) {
+		dbs_data = dbs_info->policy_dbs.dbs_data;
+		mutex_lock(&dbs_data->attr_set.update_lock);
+		zz_idle_set(dbs_data, READ_ONCE(zz_display_off));
+		mutex_unlock(&dbs_data->attr_set.update_lock);
+	}
+	mutex_unlock(&zz_policy_list_lock);
+}
 
-	ret = sscanf(buf, "%u", &input);
+static DECLARE_WORK(zz_idle_work, zz_idle_fn);
 
-	if (ret != 1 || input < 0 || input > 3)
-	    return -EINVAL;
+static int zz_fb_notifier_cb(struct notifier_block *nb, unsigned long event, void *data)
+{
+	struct fb_event *evdata = data;
 
-	zz_tuners->scaling_proportional = input;
+	if (event != FB_EVENT_BLANK || !evdata || !evdata->data)
+	    return NOTIFY_DONE;
 
-	return count;
+	WRITE_ONCE(zz_display_off, *(int *)evdata->data != FB_BLANK_UNBLANK);
+	schedule_work(&zz_idle_work);
+
+	return NOTIFY_OK;
 }
 
+static struct notifier_block zz_fb_notifier = {
+	.notifier_call = zz_fb_notifier_cb,
+};
+#endif /* CONFIG_FB */
+
+/************************** idle state end ************************/
+
+/************************** thermal limit ************************/
+
 /*
- * Yank: tunable -> possible values 1-4 to enable fast upscaling (value 1-4 = steps)
+ * ZZ: tunable -> name of the thermal zone for the thermal soft limit, empty to
+ * disable. the zone has to exist when written, afterwards it is looked up on
+ * every read and no limit applies while it is gone
  */
-static ssize_t store_fast_scaling_up(struct gov_attr_set *attr_set,
+static ssize_t store_thermal_zone(struct gov_attr_set *attr_set,
 		const char *buf, size_t count)
 {
 	struct dbs_data *dbs_data = to_dbs_data(attr_set);
 	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
-	unsigned int input;
-	int ret;
+	struct thermal_zone_device *tz;
+	char name[THERMAL_NAME_LENGTH + 1];						// ZZ: room for a trailing newline
+	char *zone;
 
-	ret = sscanf(buf, "%u", &input);
+	if (strlcpy(name, buf, sizeof(name)) >= sizeof(name))
+	    return -EINVAL;
 
-	if (ret != 1 || input > 4 || input < 0)
+	zone = strim(name);
+
+	if (strlen(zone) >= THERMAL_NAME_LENGTH)
 	    return -EINVAL;
 
-	zz_tuners->fast_scaling_up = input;
-	zz_tuners->afs_up = 0;
+	if (*zone) {
+	    tz = thermal_zone_get_zone_by_name(zone);
+	    if (IS_ERR(tz))
+		return PTR_ERR(tz);
+	}
 
-	return count;
+	strlcpy(zz_tuners->thermal_zone, zone, THERMAL_NAME_LENGTH);
+
+	return zz_publish_tuners(dbs_data) ?: count;
+}
+
+static ssize_t show_thermal_zone(struct gov_attr_set *attr_set, char *buf)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+
+	return sprintf(buf, "%s\n", zz_tuners->thermal_zone);
 }
 
 /*
- * Yank: tunable -> possible values 1-4 to enable fast downscaling (value 1-4 = steps)
+ * ZZ: tunable -> thermal trip points as list of 'temp:freq' entries (temp in
+ * millidegree celsius, ascending) with the max frequency from this temp on
+ * (not above the one of the trip before), write an empty line to clear the list
  */
-static ssize_t store_fast_scaling_down(struct gov_attr_set *attr_set,
+static ssize_t store_thermal_trips(struct gov_attr_set *attr_set,
 		const char *buf, size_t count)
 {
 	struct dbs_data *dbs_data = to_dbs_data(attr_set);
 	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
-	unsigned int input;
-	int ret;
+	unsigned int vals[ZZ_THERMAL_MAX_TRIPS * 2];
+	int i, ret;
 
-	ret = sscanf(buf, "%u", &input);
+	ret = zz_parse_tuples(buf, vals, 2, ZZ_THERMAL_MAX_TRIPS);
 
-	if (ret != 1 || input > 4 || input < 0)
-	    return -EINVAL;
+	if (ret < 0)
+	    return ret;
 
-	zz_tuners->fast_scaling_down = input;
-	zz_tuners->afs_down = 0;
+	for (i = 0; i < ret; i++) {
+		if (vals[i * 2] > INT_MAX || !vals[i * 2 + 1])
+		    return -EINVAL;
 
-	return count;
+		// ZZ: hotter trips must not allow more
+		if (i && (vals[i * 2] <= vals[(i - 1) * 2] || vals[i * 2 + 1] > vals[(i - 1) * 2 + 1]))
+		    return -EINVAL;
+	}
+
+	for (i = 0; i < ret; i++) {
+		zz_tuners->thermal_trips[i].temp = vals[i * 2];
+		zz_tuners->thermal_trips[i].freq = vals[i * 2 + 1];
+	}
+
+	zz_tuners->thermal_trip_cnt = ret;
+
+	return zz_publish_tuners(dbs_data) ?: count;
 }
 
-/*
- * ZZ: tunable -> possible values 1 to enable auto fast scaling (insane scaling)
- * for upscaling and 0 to disable auto fast scaling for upscaling
- */
-static ssize_t store_afs_up(struct gov_attr_set *attr_set,
+static ssize_t show_thermal_trips(struct gov_attr_set *attr_set, char *buf)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	ssize_t len = 0;
+	unsigned int i;
+
+	for (i = 0; i < zz_tuners->thermal_trip_cnt; i++)
+		len += scnprintf(buf + len, PAGE_SIZE - len, "%d:%u ",
+			zz_tuners->thermal_trips[i].temp, zz_tuners->thermal_trips[i].freq);
+
+	len += scnprintf(buf + len, PAGE_SIZE - len, "\n");
+	return len;
+}
+
+// ZZ: tunable -> possible values from 0 to 20000 millidegree celsius the temperature has to fall below a trip point to release it
+static ssize_t store_thermal_hysteresis(struct gov_attr_set *attr_set,
 		const char *buf, size_t count)
 {
 	struct dbs_data *dbs_data = to_dbs_data(attr_set);
@@ -553,61 +3072,65 @@ static ssize_t store_afs_up(struct gov_attr_set *attr_set,
 
 	ret = sscanf(buf, "%u", &input);
 
-	if (ret != 1 || input > 1 || input < 0)
+	if (ret != 1 || input > MAX_THERMAL_HYSTERESIS)
 	    return -EINVAL;
 
-	zz_tuners->afs_up = input;
-
-	if (input == 0)
-	    zz_tuners->fast_scaling_up = 0;
+	zz_tuners->thermal_hysteresis = input;
 
-	return count;
+	return zz_publish_tuners(dbs_data) ?: count;
 }
 
+/************************** thermal limit end ************************/
+
 /*
- * ZZ: tunable -> possible values 1 to enable auto fast scaling (insane scaling)
- * for downscaling and 0 to disable auto fast scaling for downscaling
+ * ZZ: tunable -> sibling cluster floors as list of 'cpu:freq' entries, the
+ * cluster of cpu runs at least at freq while this one is saturated, write an
+ * empty line to clear the list. entries for cpus of the saturated policy are
+ * skipped, so one shared list can hold the floors of all clusters
  */
-static ssize_t store_afs_down(struct gov_attr_set *attr_set,
+static ssize_t store_coord_floor(struct gov_attr_set *attr_set,
 		const char *buf, size_t count)
 {
 	struct dbs_data *dbs_data = to_dbs_data(attr_set);
 	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
-	unsigned int input;
-	int ret;
+	unsigned int vals[ZZ_MAX_COORD * 2];
+	int i, ret;
 
-	ret = sscanf(buf, "%u", &input);
+	ret = zz_parse_tuples(buf, vals, 2, ZZ_MAX_COORD);
 
-	if (ret != 1 || input > 1 || input < 0)
-	    return -EINVAL;
+	if (ret < 0)
+	    return ret;
 
-	zz_tuners->afs_down = input;
+	for (i = 0; i < ret; i++) {
+		if (vals[i * 2] >= nr_cpu_ids || !cpu_possible(vals[i * 2]) || !vals[i * 2 + 1])
+		    return -EINVAL;
+	}
+
+	for (i = 0; i < ret; i++) {
+		zz_tuners->coord[i].cpu = vals[i * 2];
+		zz_tuners->coord[i].freq = vals[i * 2 + 1];
+	}
 
-	if (input == 0)
-	    zz_tuners->fast_scaling_down = 0;
+	zz_tuners->coord_cnt = ret;
+	zz_tuners->coord_gen++;
 
-	return count;
+	return zz_publish_tuners(dbs_data) ?: count;
 }
 
-// ZZ: afs tunable -> possible values from 0 to 100
-#define store_afs_threshold(name)					\
-static ssize_t store_afs_threshold##name(struct gov_attr_set *attr_set,	\
-		const char *buf, size_t count)				\
-{									\
-	struct dbs_data *dbs_data = to_dbs_data(attr_set);		\
-	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;		\
-	unsigned int input;						\
-	int ret;							\
-									\
-	ret = sscanf(buf, "%u", &input);				\
-									\
-	if (ret != 1 || input > 100 || input < 0)			\
-	    return -EINVAL;						\
-									\
-	zz_tuners->afs_threshold##name = input;				\
-									\
-	return count;							\
-}									\
+static ssize_t show_coord_floor(struct gov_attr_set *attr_set, char *buf)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	ssize_t len = 0;
+	unsigned int i;
+
+	for (i = 0; i < zz_tuners->coord_cnt; i++)
+		len += scnprintf(buf + len, PAGE_SIZE - len, "%u:%u ",
+			zz_tuners->coord[i].cpu, zz_tuners->coord[i].freq);
+
+	len += scnprintf(buf + len, PAGE_SIZE - len, "\n");
+	return len;
+}
 
 // ZZ: show zzmoove version info in sysfs
 static ssize_t show_version(struct gov_attr_set *attr_set, char *buf)
@@ -638,6 +3161,23 @@ gov_show_one(zz, afs_threshold1);
 gov_show_one(zz, afs_threshold2);
 gov_show_one(zz, afs_threshold3);
 gov_show_one(zz, afs_threshold4);
+gov_show_one(zz, sched_event_rate_limit);
+gov_show_one(zz, fast_switch);
+gov_show_one(zz, load_prediction);
+gov_show_one(zz, input_boost_freq);
+gov_show_one(zz, input_boost_duration);
+gov_show_one(zz, hotplug);
+gov_show_one(zz, hotplug_min_cpus);
+gov_show_one(zz, hotplug_hysteresis);
+gov_show_one(zz, idle);
+gov_show_one(zz, idle_max_freq);
+gov_show_one(zz, thermal_hysteresis);
+gov_show_one(zz, adaptive_sampling);
+gov_show_one(zz, transition_hysteresis);
+gov_show_one(zz, iowait_boost);
+gov_show_one(zz, load_aggregation);
+gov_show_one(zz, load_aggregation_percentile);
+gov_show_one(zz, load_aggregation_discount);
 
 gov_attr_rw(sampling_rate);
 gov_attr_rw(sampling_down_factor);
@@ -655,6 +3195,31 @@ gov_attr_rw(afs_threshold1);
 gov_attr_rw(afs_threshold2);
 gov_attr_rw(afs_threshold3);
 gov_attr_rw(afs_threshold4);
+gov_attr_rw(sched_event_rate_limit);
+gov_attr_rw(fast_switch);
+gov_attr_rw(load_prediction);
+gov_attr_rw(opp_power);
+gov_attr_rw(opp_thresholds);
+gov_attr_rw(input_boost_freq);
+gov_attr_rw(input_boost_duration);
+gov_attr_rw(hotplug);
+gov_attr_rw(hotplug_min_cpus);
+gov_attr_rw(hotplug_hysteresis);
+gov_attr_rw(idle);
+gov_attr_rw(idle_profile);
+gov_attr_rw(idle_max_freq);
+gov_attr_rw(thermal_zone);
+gov_attr_rw(thermal_trips);
+gov_attr_rw(thermal_hysteresis);
+gov_attr_rw(coord_floor);
+gov_attr_rw(adaptive_sampling);
+gov_attr_rw(transition_hysteresis);
+gov_attr_rw(iowait_boost);
+gov_attr_rw(load_aggregation);
+gov_attr_rw(load_aggregation_percentile);
+gov_attr_rw(load_aggregation_discount);
+gov_attr_rw(profile);
+gov_attr_rw(profiles);
 gov_attr_ro(version);
 gov_attr_ro(min_sampling_rate);
 
@@ -676,33 +3241,370 @@ static struct attribute *zz_attributes[] = {
 	&afs_threshold2.attr,
 	&afs_threshold3.attr,
 	&afs_threshold4.attr,
+	&sched_event_rate_limit.attr,
+	&fast_switch.attr,
+	&load_prediction.attr,
+	&opp_power.attr,
+	&opp_thresholds.attr,
+	&input_boost_freq.attr,
+	&input_boost_duration.attr,
+	&hotplug.attr,
+	&hotplug_min_cpus.attr,
+	&hotplug_hysteresis.attr,
+	&idle.attr,
+	&idle_profile.attr,
+	&idle_max_freq.attr,
+	&thermal_zone.attr,
+	&thermal_trips.attr,
+	&thermal_hysteresis.attr,
+	&coord_floor.attr,
+	&adaptive_sampling.attr,
+	&transition_hysteresis.attr,
+	&iowait_boost.attr,
+	&load_aggregation.attr,
+	&load_aggregation_percentile.attr,
+	&load_aggregation_discount.attr,
+	&profile.attr,
+	&profiles.attr,
 	&version.attr,
 	NULL
 };
 
 /************************** sysfs end ************************/
 
+/************************** debugfs interface ************************/
+
+static struct dentry *zz_debugfs_root;
+
+// ZZ: show statistics of a policy, counters are read without locking so values may be one sample off
+static int zz_stats_show(struct seq_file *m, void *unused)
+{
+	struct zz_policy_dbs_info *dbs_info = m->private;
+	struct zz_policy_stats *stats = &dbs_info->stats;
+	u64 time_ms, total_ms = 0, unknown_ms = 0, freq_ms = 0;
+	u64 energy, work;
+	unsigned int i;
+
+	seq_printf(m, "up_decisions: %llu\n", READ_ONCE(stats->up_decisions));
+	seq_printf(m, "down_decisions: %llu\n", READ_ONCE(stats->down_decisions));
+	seq_printf(m, "up_suppressed: %llu\n", READ_ONCE(stats->up_suppressed));
+	seq_printf(m, "down_suppressed: %llu\n", READ_ONCE(stats->down_suppressed));
+	seq_printf(m, "table_fallbacks: %llu\n", READ_ONCE(stats->table_fallbacks));
+	seq_printf(m, "hysteresis_suppressed: %llu\n", READ_ONCE(stats->hysteresis_suppressed));
+
+	seq_puts(m, "time_in_state (freq ms):\n");
+	for (i = 0; i < dbs_info->freq_table_size; i++)
+		seq_printf(m, "%u %llu\n", dbs_info->freq_index[i],
+			div_u64(READ_ONCE(stats->time_in_state[i]), NSEC_PER_MSEC));
+
+	seq_puts(m, "load_histogram (load samples):\n");
+	for (i = 0; i < ZZ_STATS_LOAD_BUCKETS; i++)
+		seq_printf(m, "%u-%u %llu\n", i * 10, i == ZZ_STATS_LOAD_BUCKETS - 1 ? 100 : i * 10 + 9,
+			READ_ONCE(stats->load_hist[i]));
+
+	seq_puts(m, "step_histogram (steps up down):\n");
+	for (i = 0; i < ZZ_STATS_STEP_BUCKETS; i++)
+		seq_printf(m, "%u%s %llu %llu\n", i, i == ZZ_STATS_STEP_BUCKETS - 1 ? "+" : "",
+			READ_ONCE(stats->up_step_hist[i]), READ_ONCE(stats->down_step_hist[i]));
+
+	for (i = 0; i < dbs_info->freq_table_size; i++) {
+		time_ms = div_u64(READ_ONCE(stats->time_in_state[i]), NSEC_PER_MSEC);
+		total_ms += time_ms;
+		freq_ms += time_ms * dbs_info->freq_index[i];
+		if (!dbs_info->opp_power[i])
+		    unknown_ms += time_ms;
+	}
+
+	energy = READ_ONCE(stats->energy);
+	work = READ_ONCE(stats->work);
+
+	seq_printf(m, "avg_freq: %llu\n", total_ms ? div64_u64(freq_ms, total_ms) : 0);
+	seq_printf(m, "energy (power x ms): %llu\n", div_u64(energy, USEC_PER_MSEC));
+	seq_printf(m, "energy_unknown (ms without power): %llu\n", unknown_ms);
+	seq_printf(m, "avg_power: %llu\n", total_ms > unknown_ms ? div64_u64(energy, (total_ms - unknown_ms) * USEC_PER_MSEC) : 0);
+	seq_printf(m, "work (mcycles): %llu\n", div_u64(work, 1000000));
+	seq_printf(m, "energy_per_work (power x ms per mcycle): %llu\n", work >= 1000 ? div64_u64(energy, div_u64(work, 1000)) : 0);
+
+	return 0;
+}
+
+static int zz_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, zz_stats_show, inode->i_private);
+}
+
+// ZZ: any write resets the statistics, done by the sampling path at next sample to keep it the only writer
+static ssize_t zz_stats_write(struct file *file, const char __user *buf, size_t count, loff_t *ppos)
+{
+	struct seq_file *m = file->private_data;
+	struct zz_policy_dbs_info *dbs_info = m->private;
+
+	WRITE_ONCE(dbs_info->stats_reset, true);
+	return count;
+}
+
+static const struct file_operations zz_stats_fops = {
+	.owner = THIS_MODULE,
+	.open = zz_stats_open,
+	.read = seq_read,
+	.write = zz_stats_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static DEFINE_MUTEX(zz_ring_lock);
+
+// ZZ: allocate the sample ring at first open, from then on every sample of the policy is recorded
+static int zz_ring_open(struct inode *inode, struct file *file)
+{
+	struct zz_policy_dbs_info *dbs_info = inode->i_private;
+	struct zz_ring_header *ring;
+	int ret = 0;
+
+	mutex_lock(&zz_ring_lock);
+
+	if (!dbs_info->ring) {
+	    ring = vmalloc_user(ZZ_RING_SIZE);
+	    if (ring) {
+		ring->magic = ZZ_RING_MAGIC;
+		ring->version = ZZ_RING_VERSION;
+		ring->header_size = ZZ_RING_HEADER_SIZE;
+		ring->record_size = sizeof(struct zz_ring_record);
+		ring->records = ZZ_RING_RECORDS;
+		ring->cpus = ZZ_RING_CPUS;
+		smp_store_release(&dbs_info->ring, ring);
+	    } else {
+		ret = -ENOMEM;
+	    }
+	}
+
+	mutex_unlock(&zz_ring_lock);
+	file->private_data = dbs_info;
+
+	return ret;
+}
+
+static int zz_ring_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct zz_policy_dbs_info *dbs_info = file->private_data;
+
+	return remap_vmalloc_range(vma, dbs_info->ring, vma->vm_pgoff);
+}
+
+static const struct file_operations zz_ring_fops = {
+	.owner = THIS_MODULE,
+	.open = zz_ring_open,
+	.mmap = zz_ring_mmap,
+};
+
+// ZZ: create the debugfs directory of a policy if not done already
+static void zz_debugfs_init_policy(struct cpufreq_policy *policy)
+{
+	struct zz_policy_dbs_info *dbs_info = to_dbs_info(policy->governor_data);
+	char name[16];
+
+	if (IS_ERR_OR_NULL(zz_debugfs_root) || dbs_info->debugfs_dir)
+	    return;
+
+	snprintf(name, sizeof(name), "policy%u", policy->cpu);
+	dbs_info->debugfs_dir = debugfs_create_dir(name, zz_debugfs_root);
+
+	if (IS_ERR_OR_NULL(dbs_info->debugfs_dir)) {
+	    dbs_info->debugfs_dir = NULL;
+	    return;
+	}
+
+	debugfs_create_file("stats", 0644, dbs_info->debugfs_dir, dbs_info, &zz_stats_fops);
+	debugfs_create_file("ring", 0600, dbs_info->debugfs_dir, dbs_info, &zz_ring_fops);
+}
+
+/************************** debugfs end ************************/
+
+/************************** input boost ************************/
+
+static u64 zz_input_last_event;							// ZZ: time of last handled input event
+
+/*
+ * ZZ: arm the input boost on all policies with input boost enabled and let them be evaluated at the next scheduler
+ * event instead of waiting for the rest of the sampling period, the sampling path then raises to the boost freq
+ */
+static void zz_input_boost_fn(struct work_struct *work)
+{
+	struct zz_policy_dbs_info *dbs_info;
+	struct zz_dbs_tuners *zz_tuners;
+	u64 now = ktime_get_ns();
+
+	mutex_lock(&zz_policy_list_lock);
+	list_for_each_entry(dbs_info, &zz_policy_list, zz_list) {
+		zz_tuners = dbs_info->policy_dbs.dbs_data->tuners;
+
+		if (!zz_tuners->input_boost_freq)
+		    continue;
+
+		WRITE_ONCE(dbs_info->input_boost_until, now + (u64)zz_tuners->input_boost_duration * NSEC_PER_MSEC);
+
+		// ZZ: like all other delay updates under the timer mutex, so a running sample can't overwrite it again
+		mutex_lock(&dbs_info->policy_dbs.timer_mutex);
+		gov_update_sample_delay(&dbs_info->policy_dbs, 0);
+		mutex_unlock(&dbs_info->policy_dbs.timer_mutex);
+	}
+	mutex_unlock(&zz_policy_list_lock);
+}
+
+static DECLARE_WORK(zz_input_boost_work, zz_input_boost_fn);
+
+// ZZ: input events come in atomic context, rate limit them and leave the rest to the boost work
+static void zz_input_event(struct input_handle *handle, unsigned int type,
+		unsigned int code, int value)
+{
+	u64 now = ktime_get_ns();
+
+	if (now - READ_ONCE(zz_input_last_event) < ZZ_INPUT_BOOST_RATE_LIMIT * NSEC_PER_MSEC)
+	    return;
+
+	WRITE_ONCE(zz_input_last_event, now);
+	queue_work(system_highpri_wq, &zz_input_boost_work);
+}
+
+static int zz_input_connect(struct input_handler *handler,
+		struct input_dev *dev, const struct input_device_id *id)
+{
+	struct input_handle *handle;
+	int error;
+
+	handle = kzalloc(sizeof(*handle), GFP_KERNEL);
+	if (!handle)
+	    return -ENOMEM;
+
+	handle->dev = dev;
+	handle->handler = handler;
+	handle->name = "zzmoove";
+
+	error = input_register_handle(handle);
+	if (error)
+	    goto err_register;
+
+	error = input_open_device(handle);
+	if (error)
+	    goto err_open;
+
+	return 0;
+
+err_open:
+	input_unregister_handle(handle);
+err_register:
+	kfree(handle);
+	return error;
+}
+
+static void zz_input_disconnect(struct input_handle *handle)
+{
+	input_close_device(handle);
+	input_unregister_handle(handle);
+	kfree(handle);
+}
+
+static const struct input_device_id zz_input_ids[] = {
+	// ZZ: multi-touch touchscreen
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_EVBIT |
+			 INPUT_DEVICE_ID_MATCH_ABSBIT,
+		.evbit = { BIT_MASK(EV_ABS) },
+		.absbit = { [BIT_WORD(ABS_MT_POSITION_X)] =
+			    BIT_MASK(ABS_MT_POSITION_X) |
+			    BIT_MASK(ABS_MT_POSITION_Y) },
+	},
+	// ZZ: single touch touchscreen and touchpad
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_KEYBIT |
+			 INPUT_DEVICE_ID_MATCH_ABSBIT,
+		.keybit = { [BIT_WORD(BTN_TOUCH)] = BIT_MASK(BTN_TOUCH) },
+		.absbit = { [BIT_WORD(ABS_X)] =
+			    BIT_MASK(ABS_X) | BIT_MASK(ABS_Y) },
+	},
+	// ZZ: keyboard, not any device with keys so power buttons, lid switches and headset keys are left alone
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_EVBIT |
+			 INPUT_DEVICE_ID_MATCH_KEYBIT,
+		.evbit = { BIT_MASK(EV_KEY) },
+		.keybit = { [BIT_WORD(KEY_A)] = BIT_MASK(KEY_A) },
+	},
+	{ },
+};
+
+static struct input_handler zz_input_handler = {
+	.event = zz_input_event,
+	.connect = zz_input_connect,
+	.disconnect = zz_input_disconnect,
+	.name = "zzmoove",
+	.id_table = zz_input_ids,
+};
+
+static DEFINE_MUTEX(zz_input_lock);
+static unsigned int zz_input_users;						// ZZ: governor instances in use
+static bool zz_input_registered;						// ZZ: input handler registered
+
+// ZZ: the input handler opens all matching devices, so it is only registered while zzmoove is used by a policy
+static void zz_input_get(void)
+{
+	mutex_lock(&zz_input_lock);
+	if (!zz_input_users++) {
+	    zz_input_registered = !input_register_handler(&zz_input_handler);
+	    if (!zz_input_registered)
+		pr_warn("zzmoove: failed to register input handler, input boost not available\n");
+	}
+	mutex_unlock(&zz_input_lock);
+}
+
+static void zz_input_put(void)
+{
+	mutex_lock(&zz_input_lock);
+	if (!--zz_input_users && zz_input_registered) {
+	    input_unregister_handler(&zz_input_handler);
+	    zz_input_registered = false;
+	}
+	mutex_unlock(&zz_input_lock);
+}
+
+/************************** input boost end ************************/
+
 static struct policy_dbs_info *zz_alloc(void)
 {
 	struct zz_policy_dbs_info *dbs_info;
 
 	dbs_info = kzalloc(sizeof(*dbs_info), GFP_KERNEL);
-	return dbs_info ? &dbs_info->policy_dbs : NULL;
+	if (!dbs_info)
+	    return NULL;
+
+	INIT_LIST_HEAD(&dbs_info->zz_list);
+	return &dbs_info->policy_dbs;
 }
 
 static void zz_free(struct policy_dbs_info *policy_dbs)
 {
+	mutex_lock(&zz_policy_list_lock);
+	list_del_init(&to_dbs_info(policy_dbs)->zz_list);
+	mutex_unlock(&zz_policy_list_lock);
+
+	zz_hotplug_allow(policy_dbs->policy, false);
+	zz_coord_release(to_dbs_info(policy_dbs));
+	cpufreq_disable_fast_switch(policy_dbs->policy);
+	debugfs_remove_recursive(to_dbs_info(policy_dbs)->debugfs_dir);
+	vfree(to_dbs_info(policy_dbs)->ring);
 	kfree(to_dbs_info(policy_dbs));
 }
 
 static int zz_init(struct dbs_data *dbs_data)
 {
+	struct zz_tuners_ext *ext;
 	struct zz_dbs_tuners *tuners;
 
-	tuners = kzalloc(sizeof(*tuners), GFP_KERNEL);
-	if (!tuners)
+	ext = kzalloc(sizeof(*ext), GFP_KERNEL);
+	if (!ext)
 	    return -ENOMEM;
 
+	tuners = &ext->tuners;
+
 	tuners->sampling_up_factor = DEF_SAMPLING_UP_FACTOR;
 	tuners->down_threshold = DEF_FREQUENCY_DOWN_THRESHOLD;
 	tuners->smooth_up = DEF_SMOOTH_UP;
@@ -715,6 +3617,25 @@ static int zz_init(struct dbs_data *dbs_data)
 	tuners->afs_threshold2 = DEF_AFS_THRESHOLD2;
 	tuners->afs_threshold3 = DEF_AFS_THRESHOLD3;
 	tuners->afs_threshold4 = DEF_AFS_THRESHOLD4;
+	tuners->sched_event_rate_limit = DEF_SCHED_EVENT_RATE_LIMIT;
+	tuners->fast_switch = DEF_FAST_SWITCH;
+	tuners->load_prediction = DEF_LOAD_PREDICTION;
+	tuners->input_boost_freq = DEF_INPUT_BOOST_FREQ;
+	tuners->input_boost_duration = DEF_INPUT_BOOST_DURATION;
+	memcpy(ext->profiles, zz_default_profiles, sizeof(zz_default_profiles));
+	ext->profile_cnt = ARRAY_SIZE(zz_default_profiles);
+	ext->profile_active = -1;
+	tuners->hotplug = DEF_HOTPLUG;
+	tuners->hotplug_min_cpus = DEF_HOTPLUG_MIN_CPUS;
+	tuners->hotplug_hysteresis = DEF_HOTPLUG_HYSTERESIS;
+	tuners->idle_max_freq = DEF_IDLE_MAX_FREQ;
+	tuners->thermal_hysteresis = DEF_THERMAL_HYSTERESIS;
+	tuners->adaptive_sampling = DEF_ADAPTIVE_SAMPLING;
+	tuners->transition_hysteresis = DEF_TRANSITION_HYSTERESIS;
+	tuners->iowait_boost = DEF_IOWAIT_BOOST;
+	tuners->load_aggregation = DEF_LOAD_AGGREGATION;
+	tuners->load_aggregation_percentile = DEF_LOAD_AGGREGATION_PERCENTILE;
+	tuners->load_aggregation_discount = DEF_LOAD_AGGREGATION_DISCOUNT;
 
 	dbs_data->up_threshold = DEF_FREQUENCY_UP_THRESHOLD;
 	dbs_data->sampling_down_factor = DEF_SAMPLING_DOWN_FACTOR;
@@ -723,24 +3644,84 @@ static int zz_init(struct dbs_data *dbs_data)
 	dbs_data->min_sampling_rate = MIN_SAMPLING_RATE_RATIO *
 		jiffies_to_usecs(10);
 
+	if (zz_publish_tuners(dbs_data)) {
+	    kfree(ext);
+	    return -ENOMEM;
+	}
+
+	zz_input_get();
 	return 0;
 }
 
 static void zz_exit(struct dbs_data *dbs_data)
 {
-	kfree(dbs_data->tuners);
+	struct zz_dbs_tuners *zz_tuners = dbs_data->tuners;
+	struct zz_policy_dbs_info *dbs_info, *tmp;
+
+	// ZZ: governor core frees dbs data before the policies, so they must not be found by list users anymore
+	mutex_lock(&zz_policy_list_lock);
+	list_for_each_entry_safe(dbs_info, tmp, &zz_policy_list, zz_list) {
+		if (dbs_info->policy_dbs.dbs_data == dbs_data)
+		    list_del_init(&dbs_info->zz_list);
+	}
+	mutex_unlock(&zz_policy_list_lock);
+
+	// ZZ: no sampling is running anymore at this point, so the last snapshot and the tables can go right away
+	kfree(rcu_dereference_protected(zz_tuners->snap, true));
+	kfree(rcu_dereference_protected(zz_tuners->opp_power, true));
+	kfree(rcu_dereference_protected(zz_tuners->opp_thresholds, true));
+	kfree(to_tuners_ext(dbs_data));
+	zz_input_put();
 }
 
 static void zz_start(struct cpufreq_policy *policy)
 {
 	struct zz_policy_dbs_info *dbs_info = to_dbs_info(policy->governor_data);
+	struct zz_dbs_tuners *zz_tuners = dbs_info->policy_dbs.dbs_data->tuners;
 
 	dbs_info->down_skip = 0;
 	dbs_info->up_skip = 0;
+	dbs_info->afs_scaling_up = 0;
+	dbs_info->afs_scaling_down = 0;
+	dbs_info->last_full_sample_time = 0;
+	dbs_info->event_load_sum = 0;
+	dbs_info->event_max_load_sum = 0;
+	dbs_info->event_time = 0;
+	dbs_info->event_last_time = 0;
+	dbs_info->load_history_pos = 0;
+	dbs_info->load_history_cnt = 0;
 	dbs_info->pol_max = policy->max;
 	dbs_info->pol_min = policy->min;
 	dbs_info->requested_freq = policy->cur;
 	dbs_info->freq_table = policy->freq_table;
+	dbs_info->stats.last_update = 0;
+	dbs_info->hotplug_up_skip = 0;
+	dbs_info->hotplug_down_skip = 0;
+	dbs_info->thermal_temp = 0;
+	dbs_info->thermal_trip = -1;
+	dbs_info->thermal_last_poll = 0;
+	// ZZ: the core has no stop callback, so floors raised before the last stop are released here
+	zz_coord_release(dbs_info);
+	dbs_info->sample_interval = 0;
+	dbs_info->last_transition_dir = 0;
+	dbs_info->reversal_period = 0;
+	dbs_info->iowait_boost_freq = 0;
+	dbs_info->cpu_loads_tracked = false;
+
+	rcu_read_lock();
+	evaluate_scaling_order_limit_range(policy, &rcu_dereference(zz_tuners->snap)->tuners);
+	rcu_read_unlock();
+
+	zz_debugfs_init_policy(policy);
+	zz_hotplug_allow(policy, zz_tuners->hotplug);
+
+	mutex_lock(&zz_policy_list_lock);
+	if (list_empty(&dbs_info->zz_list))
+	    list_add_tail(&dbs_info->zz_list, &zz_policy_list);
+	mutex_unlock(&zz_policy_list_lock);
+
+	// ZZ: fast switching only if enabled by tunable, so it doesn't block transition notifiers otherwise
+	zz_fast_switch_enable(policy, zz_tuners->fast_switch);
 }
 
 #ifndef CONFIG_CPU_FREQ_DEFAULT_GOV_ZZMOOVE
@@ -761,12 +3742,26 @@ struct dbs_governor zz_governor = {
 
 static int __init cpufreq_gov_dbs_init(void)
 {
+    zz_debugfs_root = debugfs_create_dir("zzmoove", NULL);
+
+#ifdef CONFIG_FB
+    if (fb_register_client(&zz_fb_notifier))
+	pr_warn("zzmoove: failed to register display notifier, idle state only available by sysfs\n");
+#endif
+
     return cpufreq_register_governor(CPU_FREQ_GOV_ZZMOOVE);
 }
 
 static void __exit cpufreq_gov_dbs_exit(void)
 {
     cpufreq_unregister_governor(CPU_FREQ_GOV_ZZMOOVE);
+    cancel_work_sync(&zz_input_boost_work);
+    flush_work(&zz_hotplug_work);
+#ifdef CONFIG_FB
+    fb_unregister_client(&zz_fb_notifier);
+    cancel_work_sync(&zz_idle_work);
+#endif
+    debugfs_remove_recursive(zz_debugfs_root);
 }
 
 MODULE_AUTHOR("Zane Zaminsky <cyxman@yahoo.com>");
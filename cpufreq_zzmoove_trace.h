@@ -0,0 +1,123 @@
+/*
+ *  drivers/cpufreq/cpufreq_zzmoove_trace.h
+ *
+ *  Tracepoints for the zzmoove governor scaling decisions
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM zzmoove
+
+#if !defined(_TRACE_CPUFREQ_ZZMOOVE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_CPUFREQ_ZZMOOVE_H
+
+#include <linux/tracepoint.h>
+
+#ifndef _CPUFREQ_ZZMOOVE_TRACE_DEFS
+#define _CPUFREQ_ZZMOOVE_TRACE_DEFS
+// ZZ: ways zz_get_next_freq() found the target frequency
+#define ZZ_PATH_TABLE				(0)	// ZZ: step in scaling index
+#define ZZ_PATH_PROPORTIONAL			(1)	// ZZ: proportional target frequency
+#define ZZ_PATH_FALLBACK			(2)	// ZZ: current freq not in scaling index, proportional fallback
+#define ZZ_PATH_ENERGY				(3)	// ZZ: lowest energy step providing the required capacity
+#endif
+
+// ZZ: one event per sample of a policy with the decision taken (direction 1 = up, -1 = down, 0 = none)
+TRACE_EVENT(zzmoove_sample,
+
+	TP_PROTO(unsigned int cpu, unsigned int load, unsigned int prev_load,
+		 unsigned int cur_freq, unsigned int requested_freq, int direction,
+		 unsigned int afs_up, unsigned int afs_down,
+		 unsigned int up_skip, unsigned int down_skip),
+
+	TP_ARGS(cpu, load, prev_load, cur_freq, requested_freq, direction,
+		afs_up, afs_down, up_skip, down_skip),
+
+	TP_STRUCT__entry(
+		__field(unsigned int,	cpu)
+		__field(unsigned int,	load)
+		__field(unsigned int,	prev_load)
+		__field(unsigned int,	cur_freq)
+		__field(unsigned int,	requested_freq)
+		__field(int,		direction)
+		__field(unsigned int,	afs_up)
+		__field(unsigned int,	afs_down)
+		__field(unsigned int,	up_skip)
+		__field(unsigned int,	down_skip)
+	),
+
+	TP_fast_assign(
+		__entry->cpu = cpu;
+		__entry->load = load;
+		__entry->prev_load = prev_load;
+		__entry->cur_freq = cur_freq;
+		__entry->requested_freq = requested_freq;
+		__entry->direction = direction;
+		__entry->afs_up = afs_up;
+		__entry->afs_down = afs_down;
+		__entry->up_skip = up_skip;
+		__entry->down_skip = down_skip;
+	),
+
+	TP_printk("cpu=%u load=%u prev_load=%u cur=%u requested=%u dir=%d afs_up=%u afs_down=%u up_skip=%u down_skip=%u",
+		  __entry->cpu, __entry->load, __entry->prev_load,
+		  __entry->cur_freq, __entry->requested_freq, __entry->direction,
+		  __entry->afs_up, __entry->afs_down,
+		  __entry->up_skip, __entry->down_skip)
+);
+
+// ZZ: one event per target calculation with the steps used and the way the target was found
+TRACE_EVENT(zzmoove_next_freq,
+
+	TP_PROTO(unsigned int cpu, unsigned int cur_freq, unsigned int target_freq,
+		 unsigned int updown, unsigned int load, int smooth_up_steps,
+		 unsigned int fast_scaling, unsigned int path),
+
+	TP_ARGS(cpu, cur_freq, target_freq, updown, load, smooth_up_steps,
+		fast_scaling, path),
+
+	TP_STRUCT__entry(
+		__field(unsigned int,	cpu)
+		__field(unsigned int,	cur_freq)
+		__field(unsigned int,	target_freq)
+		__field(unsigned int,	updown)
+		__field(unsigned int,	load)
+		__field(int,		smooth_up_steps)
+		__field(unsigned int,	fast_scaling)
+		__field(unsigned int,	path)
+	),
+
+	TP_fast_assign(
+		__entry->cpu = cpu;
+		__entry->cur_freq = cur_freq;
+		__entry->target_freq = target_freq;
+		__entry->updown = updown;
+		__entry->load = load;
+		__entry->smooth_up_steps = smooth_up_steps;
+		__entry->fast_scaling = fast_scaling;
+		__entry->path = path;
+	),
+
+	TP_printk("cpu=%u cur=%u target=%u %s load=%u smooth_up=%d fast_scaling=%u path=%s",
+		  __entry->cpu, __entry->cur_freq, __entry->target_freq,
+		  __entry->updown == 1 ? "up" : "down", __entry->load,
+		  __entry->smooth_up_steps, __entry->fast_scaling,
+		  __print_symbolic(__entry->path,
+				   { ZZ_PATH_TABLE,		"table" },
+				   { ZZ_PATH_PROPORTIONAL,	"proportional" },
+				   { ZZ_PATH_FALLBACK,		"fallback" },
+				   { ZZ_PATH_ENERGY,		"energy" }))
+);
+
+#endif /* _TRACE_CPUFREQ_ZZMOOVE_H */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH ../../drivers/cpufreq
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE cpufreq_zzmoove_trace
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
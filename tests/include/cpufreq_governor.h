@@ -0,0 +1,323 @@
+/*
+ *  tests/include/cpufreq_governor.h
+ *
+ *  Userspace stub of drivers/cpufreq/cpufreq_governor.h (kernel 4.9) with the parts of the cpufreq core and the
+ *  common dbs governor code the zzmoove governor uses. the frequency driver sets the frequency resolved from the
+ *  policy table like the core does and counts the transitions, dbs_update() calculates the load from the cpu times
+ *  advanced by the harness
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef _CPUFREQ_GOVERNOR_H
+#define _CPUFREQ_GOVERNOR_H
+
+#include "zz_kernel.h"
+
+/* cpufreq core */
+#define CPUFREQ_ENTRY_INVALID		~0u
+#define CPUFREQ_TABLE_END		~1u
+#define CPUFREQ_RELATION_L		0
+#define CPUFREQ_RELATION_H		1
+#define CPUFREQ_ETERNAL			(-1)
+
+struct cpufreq_frequency_table {
+	unsigned int flags;
+	unsigned int driver_data;
+	unsigned int frequency;
+};
+
+#define cpufreq_for_each_entry(pos, table)					\
+	for (pos = table; pos->frequency != CPUFREQ_TABLE_END; pos++)
+#define cpufreq_for_each_valid_entry(pos, table)				\
+	for (pos = table; pos->frequency != CPUFREQ_TABLE_END; pos++)		\
+		if (pos->frequency == CPUFREQ_ENTRY_INVALID)			\
+			continue;						\
+		else
+
+struct cpufreq_cpuinfo {
+	unsigned int max_freq;
+	unsigned int min_freq;
+	unsigned int transition_latency;
+};
+
+struct cpufreq_governor {
+	char name[16];
+};
+
+#define CPUFREQ_DBS_GOVERNOR_INITIALIZER(_name_)	{ .name = _name_ }
+
+struct cpufreq_policy {
+	struct cpumask cpus[1];
+	struct cpumask related_cpus[1];
+	unsigned int cpu;
+	unsigned int min;
+	unsigned int max;
+	unsigned int cur;
+	struct cpufreq_cpuinfo cpuinfo;
+	struct cpufreq_governor *governor;
+	void *governor_data;
+	struct cpufreq_frequency_table *freq_table;
+	bool fast_switch_possible;
+	bool fast_switch_enabled;
+	struct rw_semaphore rwsem;
+};
+
+/* transitions done by the emulated driver */
+static unsigned long zz_stub_transitions;
+
+// the frequency the driver would set, resolved from the policy table within the policy limits like the core does
+static inline unsigned int zz_stub_resolve_freq(struct cpufreq_policy *policy, unsigned int target, unsigned int relation)
+{
+	struct cpufreq_frequency_table *pos;
+	unsigned int best = CPUFREQ_ENTRY_INVALID;
+	unsigned int lowest = CPUFREQ_ENTRY_INVALID, highest = 0;
+
+	target = clamp_val(target, policy->min, policy->max);
+
+	cpufreq_for_each_valid_entry(pos, policy->freq_table) {
+		if (pos->frequency < policy->min || pos->frequency > policy->max)
+			continue;
+		if (pos->frequency < lowest)
+			lowest = pos->frequency;
+		if (pos->frequency > highest)
+			highest = pos->frequency;
+		if (relation == CPUFREQ_RELATION_L && pos->frequency >= target
+		    && (best == CPUFREQ_ENTRY_INVALID || pos->frequency < best))
+			best = pos->frequency;
+		if (relation == CPUFREQ_RELATION_H && pos->frequency <= target
+		    && (best == CPUFREQ_ENTRY_INVALID || pos->frequency > best))
+			best = pos->frequency;
+	}
+
+	if (best != CPUFREQ_ENTRY_INVALID)
+		return best;
+
+	return relation == CPUFREQ_RELATION_L ? highest : lowest;
+}
+
+static inline int __cpufreq_driver_target(struct cpufreq_policy *policy, unsigned int target_freq, unsigned int relation)
+{
+	unsigned int freq = zz_stub_resolve_freq(policy, target_freq, relation);
+
+	if (freq != policy->cur) {
+		policy->cur = freq;
+		zz_stub_transitions++;
+	}
+	return 0;
+}
+
+static inline unsigned int cpufreq_driver_fast_switch(struct cpufreq_policy *policy, unsigned int target_freq)
+{
+	unsigned int freq = zz_stub_resolve_freq(policy, target_freq, CPUFREQ_RELATION_L);
+
+	if (freq != policy->cur)
+		zz_stub_transitions++;
+	return freq;
+}
+
+/* fast switching, enabled policies block the registration of transition notifiers. enabling counts every call */
+static int zz_stub_fast_switch_count;
+
+static inline void cpufreq_enable_fast_switch(struct cpufreq_policy *policy)
+{
+	if (!policy->fast_switch_possible)
+		return;
+	policy->fast_switch_enabled = true;
+	zz_stub_fast_switch_count++;
+}
+
+static inline void cpufreq_disable_fast_switch(struct cpufreq_policy *policy)
+{
+	if (!policy->fast_switch_enabled)
+		return;
+	policy->fast_switch_enabled = false;
+	zz_stub_fast_switch_count--;
+}
+
+static inline int cpufreq_register_governor(struct cpufreq_governor *governor) { return 0; }
+static inline void cpufreq_unregister_governor(struct cpufreq_governor *governor) { }
+
+/* governor attribute sets */
+struct gov_attr_set {
+	struct kobject kobj;
+	struct list_head policy_list;
+	struct mutex update_lock;
+	int usage_count;
+};
+
+struct governor_attr {
+	struct attribute attr;
+	ssize_t (*show)(struct gov_attr_set *attr_set, char *buf);
+	ssize_t (*store)(struct gov_attr_set *attr_set, const char *buf, size_t count);
+};
+
+/* common dbs governor */
+#define MIN_SAMPLING_RATE_RATIO		(2)
+#define LATENCY_MULTIPLIER		(1000)
+
+struct dbs_data {
+	struct gov_attr_set attr_set;
+	void *tuners;
+	unsigned int min_sampling_rate;
+	unsigned int ignore_nice_load;
+	unsigned int sampling_rate;
+	unsigned int sampling_down_factor;
+	unsigned int up_threshold;
+	unsigned int io_is_busy;
+};
+
+static inline struct dbs_data *to_dbs_data(struct gov_attr_set *attr_set)
+{
+	return container_of(attr_set, struct dbs_data, attr_set);
+}
+
+#define gov_show_one(_gov, file_name)						\
+static ssize_t show_##file_name							\
+(struct gov_attr_set *attr_set, char *buf)					\
+{										\
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);			\
+	struct _gov##_dbs_tuners *tuners = dbs_data->tuners;			\
+	return sprintf(buf, "%u\n", tuners->file_name);			\
+}
+
+#define gov_show_one_common(file_name)						\
+static ssize_t show_##file_name							\
+(struct gov_attr_set *attr_set, char *buf)					\
+{										\
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);			\
+	return sprintf(buf, "%u\n", dbs_data->file_name);			\
+}
+
+#define gov_attr_ro(_name)							\
+static struct governor_attr _name =						\
+__ATTR(_name, 0444, show_##_name, NULL)
+
+#define gov_attr_rw(_name)							\
+static struct governor_attr _name =						\
+__ATTR(_name, 0644, show_##_name, store_##_name)
+
+struct update_util_data {
+	void (*func)(struct update_util_data *data, u64 time, unsigned int flags);
+};
+
+struct policy_dbs_info {
+	struct cpufreq_policy *policy;
+	struct mutex timer_mutex;
+	u64 last_sample_time;
+	s64 sample_delay_ns;
+	atomic_t work_count;
+	struct work_struct work;
+	struct dbs_data *dbs_data;
+	struct list_head list;
+	unsigned int rate_mult;
+	unsigned int idle_periods;
+	bool is_shared;
+	bool work_in_progress;
+};
+
+static inline void gov_update_sample_delay(struct policy_dbs_info *policy_dbs, unsigned int delay_us)
+{
+	policy_dbs->sample_delay_ns = delay_us * NSEC_PER_USEC;
+}
+
+static inline ssize_t store_sampling_rate(struct gov_attr_set *attr_set, const char *buf, size_t count)
+{
+	struct dbs_data *dbs_data = to_dbs_data(attr_set);
+	struct policy_dbs_info *policy_dbs;
+	unsigned int rate;
+
+	if (sscanf(buf, "%u", &rate) != 1)
+		return -EINVAL;
+
+	dbs_data->sampling_rate = max(rate, dbs_data->min_sampling_rate);
+
+	list_for_each_entry(policy_dbs, &attr_set->policy_list, list)
+		gov_update_sample_delay(policy_dbs, 0);
+
+	return count;
+}
+
+struct cpu_dbs_info {
+	u64 prev_cpu_idle;
+	u64 prev_update_time;
+	u64 prev_cpu_nice;
+	unsigned int prev_load;
+	struct update_util_data update_util;
+	struct policy_dbs_info *policy_dbs;
+};
+
+struct kobj_type {
+	struct attribute **default_attrs;
+};
+
+struct dbs_governor {
+	struct cpufreq_governor gov;
+	struct kobj_type kobj_type;
+	struct dbs_data *gdbs_data;
+	unsigned int (*gov_dbs_timer)(struct cpufreq_policy *policy);
+	struct policy_dbs_info *(*alloc)(void);
+	void (*free)(struct policy_dbs_info *policy_dbs);
+	int (*init)(struct dbs_data *dbs_data);
+	void (*exit)(struct dbs_data *dbs_data);
+	void (*start)(struct cpufreq_policy *policy);
+};
+
+static struct cpu_dbs_info zz_stub_cpu_dbs[NR_CPUS];
+
+static inline void gov_update_cpu_data(struct dbs_data *dbs_data)
+{
+	unsigned int j;
+
+	for_each_possible_cpu(j) {
+		zz_stub_cpu_dbs[j].prev_cpu_idle = get_cpu_idle_time(j, &zz_stub_cpu_dbs[j].prev_update_time,
+			dbs_data->io_is_busy);
+		zz_stub_cpu_dbs[j].prev_cpu_nice = kcpustat_cpu(j).cpustat[CPUTIME_NICE];
+	}
+}
+
+// max load of all cpus of the policy since the last call, like the common dbs code calculates it
+static inline unsigned int dbs_update(struct cpufreq_policy *policy)
+{
+	struct policy_dbs_info *policy_dbs = policy->governor_data;
+	struct dbs_data *dbs_data = policy_dbs->dbs_data;
+	unsigned int max_load = 0;
+	unsigned int sampling_rate;
+	unsigned int j;
+
+	// the idle wakeup check is scaled by the rate multiplier of the governor
+	sampling_rate = dbs_data->sampling_rate * policy_dbs->rate_mult;
+
+	for_each_cpu(j, policy->cpus) {
+		struct cpu_dbs_info *j_cdbs = &zz_stub_cpu_dbs[j];
+		u64 cur_wall_time, cur_idle_time;
+		unsigned int idle_time, wall_time, load;
+
+		cur_idle_time = get_cpu_idle_time(j, &cur_wall_time, dbs_data->io_is_busy);
+		wall_time = cur_wall_time - j_cdbs->prev_update_time;
+		j_cdbs->prev_update_time = cur_wall_time;
+		idle_time = cur_idle_time > j_cdbs->prev_cpu_idle ? cur_idle_time - j_cdbs->prev_cpu_idle : 0;
+		j_cdbs->prev_cpu_idle = cur_idle_time;
+
+		if (unlikely(!wall_time || wall_time < idle_time))
+			continue;
+
+		// a cpu that was idle for long and just woke up reports the load of the period before once
+		if (unlikely(wall_time > (2 * sampling_rate) && j_cdbs->prev_load)) {
+			load = j_cdbs->prev_load;
+			j_cdbs->prev_load = 0;
+		} else {
+			load = 100 * (wall_time - idle_time) / wall_time;
+			j_cdbs->prev_load = load;
+		}
+
+		if (load > max_load)
+			max_load = load;
+	}
+
+	return max_load;
+}
+
+#endif /* _CPUFREQ_GOVERNOR_H */
@@ -0,0 +1,2 @@
+/* userspace stub, see zz_kernel.h */
+#include "../zz_kernel.h"
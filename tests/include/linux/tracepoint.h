@@ -0,0 +1,15 @@
+/* userspace stub, tracepoints compile to empty functions */
+#include "../zz_kernel.h"
+
+#ifndef _ZZ_TRACEPOINT_H
+#define _ZZ_TRACEPOINT_H
+
+#define TRACE_EVENT(name, proto, args, tstruct, assign, print)	\
+	static inline void trace_##name(proto) { }
+#define TP_PROTO(...)			__VA_ARGS__
+#define TP_ARGS(...)
+#define TP_STRUCT__entry(...)
+#define TP_fast_assign(...)
+#define TP_printk(...)
+
+#endif
@@ -0,0 +1 @@
+/* userspace stub, tracepoints are not created in the harness */
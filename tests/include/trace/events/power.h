@@ -0,0 +1,9 @@
+/* userspace stub, see zz_kernel.h */
+#include "../../zz_kernel.h"
+
+#ifndef _ZZ_TRACE_POWER_H
+#define _ZZ_TRACE_POWER_H
+
+static inline void trace_cpu_frequency(unsigned int frequency, unsigned int cpu_id) { }
+
+#endif
@@ -0,0 +1,579 @@
+/*
+ *  tests/include/zz_kernel.h
+ *
+ *  Userspace replacement of the kernel api used by the zzmoove governor, so the governor source can be built and
+ *  driven as it is by the test harness and the replay tool. all kernel headers of the governor include this file.
+ *  time, loads, temperature and the frequency driver are emulated by the zz_stub_* variables and functions below
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef _ZZ_KERNEL_H
+#define _ZZ_KERNEL_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <limits.h>
+
+typedef unsigned long long u64;
+typedef long long s64;
+typedef uint32_t u32;
+typedef int32_t s32;
+typedef uint16_t u16;
+typedef uint8_t u8;
+typedef int8_t s8;
+typedef unsigned int gfp_t;
+typedef unsigned long long cputime64_t;
+
+#define GFP_KERNEL			0
+#define __init
+#define __exit
+#define __rcu
+#define __user
+#define __read_mostly
+#define likely(x)			__builtin_expect(!!(x), 1)
+#define unlikely(x)			__builtin_expect(!!(x), 0)
+
+#define HZ				1000
+#define NSEC_PER_USEC			1000ULL
+#define NSEC_PER_MSEC			1000000ULL
+#define USEC_PER_MSEC			1000ULL
+#define USEC_PER_SEC			1000000UL
+#define PAGE_SIZE			4096UL
+#define PAGE_ALIGN(x)			(((x) + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1))
+
+#define min(x, y) ({ typeof(x) _min1 = (x); typeof(y) _min2 = (y); (void) (&_min1 == &_min2); _min1 < _min2 ? _min1 : _min2; })
+#define max(x, y) ({ typeof(x) _max1 = (x); typeof(y) _max2 = (y); (void) (&_max1 == &_max2); _max1 > _max2 ? _max1 : _max2; })
+#define min_t(type, x, y) ({ type __min1 = (x); type __min2 = (y); __min1 < __min2 ? __min1 : __min2; })
+#define max_t(type, x, y) ({ type __max1 = (x); type __max2 = (y); __max1 > __max2 ? __max1 : __max2; })
+#define clamp(val, lo, hi)		min(max(val, lo), hi)
+#define clamp_val(val, lo, hi)		min_t(typeof(val), max_t(typeof(val), val, lo), hi)
+#undef abs
+#define abs(x) ({ typeof(x) __x = (x); __x < 0 ? -__x : __x; })
+#define ARRAY_SIZE(a)			(sizeof(a) / sizeof((a)[0]))
+#define container_of(ptr, type, member)	((type *)((char *)(ptr) - offsetof(type, member)))
+#define READ_ONCE(x)			(*(volatile typeof(x) *)&(x))
+#define WRITE_ONCE(x, val)		(*(volatile typeof(x) *)&(x) = (val))
+#define DIV_ROUND_UP(n, d)		(((n) + (d) - 1) / (d))
+#define BUILD_BUG_ON(cond)		((void)sizeof(char[1 - 2 * !!(cond)]))
+#define smp_wmb()			__sync_synchronize()
+#define smp_rmb()			__sync_synchronize()
+#define smp_store_release(p, v)		__atomic_store_n(p, v, __ATOMIC_RELEASE)
+#define smp_load_acquire(p)		__atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define cmpxchg(p, o, n) ({ typeof(*(p)) __o = (o); __atomic_compare_exchange_n(p, &__o, n, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); __o; })
+
+#define pr_warn(...)			do { } while (0)
+#define pr_warn_once(...)		do { } while (0)
+#define pr_info(...)			do { } while (0)
+#define pr_err(...)			do { } while (0)
+
+#define module_init(fn)
+#define module_exit(fn)
+#define fs_initcall(fn)
+#define MODULE_AUTHOR(x)
+#define MODULE_DESCRIPTION(x)
+#define MODULE_LICENSE(x)
+#define EXPORT_SYMBOL(x)
+#define EXPORT_SYMBOL_GPL(x)
+#define THIS_MODULE			NULL
+
+/* errors */
+#define MAX_ERRNO			4095
+#define IS_ERR_VALUE(x)			((unsigned long)(void *)(x) >= (unsigned long)-MAX_ERRNO)
+static inline void *ERR_PTR(long error) { return (void *)error; }
+static inline long PTR_ERR(const void *ptr) { return (long)ptr; }
+static inline bool IS_ERR(const void *ptr) { return IS_ERR_VALUE(ptr); }
+static inline bool IS_ERR_OR_NULL(const void *ptr) { return !ptr || IS_ERR_VALUE(ptr); }
+
+/* memory, with zz_stub_alloc_fail set to n the n-th allocation from now on fails */
+static int zz_stub_alloc_fail;
+
+static inline void *kmalloc(size_t size, gfp_t flags)
+{
+	if (zz_stub_alloc_fail && !--zz_stub_alloc_fail)
+		return NULL;
+	return malloc(size);
+}
+
+static inline void *kzalloc(size_t size, gfp_t flags)
+{
+	void *p = kmalloc(size, flags);
+
+	if (p)
+		memset(p, 0, size);
+	return p;
+}
+
+static inline void kfree(const void *p) { free((void *)p); }
+#define kfree_rcu(p, field)		kfree(p)
+static inline void *vmalloc_user(unsigned long size) { return calloc(1, size); }
+static inline void vfree(const void *p) { free((void *)p); }
+
+static inline char *kstrndup(const char *s, size_t max, gfp_t gfp)
+{
+	size_t len = strnlen(s, max);
+	char *p = kmalloc(len + 1, gfp);
+
+	if (p) {
+		memcpy(p, s, len);
+		p[len] = '\0';
+	}
+	return p;
+}
+
+/* strings */
+static inline size_t strlcpy(char *dest, const char *src, size_t size)
+{
+	size_t ret = strlen(src);
+
+	if (size) {
+		size_t len = ret >= size ? size - 1 : ret;
+
+		memcpy(dest, src, len);
+		dest[len] = '\0';
+	}
+	return ret;
+}
+
+static inline char *skip_spaces(const char *str)
+{
+	while (isspace(*str))
+		++str;
+	return (char *)str;
+}
+
+static inline char *strim(char *s)
+{
+	size_t size = strlen(s);
+	char *end;
+
+	if (!size)
+		return s;
+
+	end = s + size - 1;
+	while (end >= s && isspace(*end))
+		end--;
+	*(end + 1) = '\0';
+
+	return skip_spaces(s);
+}
+
+static inline bool sysfs_streq(const char *s1, const char *s2)
+{
+	while (*s1 && *s1 == *s2) {
+		s1++;
+		s2++;
+	}
+
+	if (*s1 == *s2)
+		return true;
+	if (!*s1 && *s2 == '\n' && !s2[1])
+		return true;
+	if (*s1 == '\n' && !s1[1] && !*s2)
+		return true;
+	return false;
+}
+
+static inline int kstrtouint(const char *s, unsigned int base, unsigned int *res)
+{
+	unsigned long val;
+	char *end;
+
+	errno = 0;
+	val = strtoul(s, &end, base);
+	if (end == s || errno || val > UINT_MAX)
+		return -EINVAL;
+	if (*end == '\n')
+		end++;
+	if (*end)
+		return -EINVAL;
+	*res = val;
+	return 0;
+}
+
+static inline int scnprintf(char *buf, size_t size, const char *fmt, ...)
+{
+	va_list args;
+	int i;
+
+	va_start(args, fmt);
+	i = vsnprintf(buf, size, fmt, args);
+	va_end(args);
+
+	if (i < (int)size)
+		return i;
+	return size ? size - 1 : 0;
+}
+
+static inline void sort(void *base, size_t num, size_t size, int (*cmp)(const void *, const void *),
+	void (*swap)(void *, void *, int))
+{
+	qsort(base, num, size, cmp);
+}
+
+/* math */
+static inline u64 div_u64(u64 dividend, u32 divisor) { return dividend / divisor; }
+static inline s64 div_s64(s64 dividend, s32 divisor) { return dividend / divisor; }
+static inline u64 div64_u64(u64 dividend, u64 divisor) { return dividend / divisor; }
+#define do_div(n, base) ({ u32 __rem = (n) % (base); (n) /= (base); __rem; })
+
+/* time, driven by the harness */
+static u64 zz_stub_now;
+
+static inline u64 ktime_get_ns(void) { return zz_stub_now; }
+static inline u64 local_clock(void) { return zz_stub_now; }
+static inline unsigned int jiffies_to_usecs(unsigned long j) { return j * (USEC_PER_SEC / HZ); }
+
+/* lists */
+struct list_head {
+	struct list_head *next, *prev;
+};
+
+#define LIST_HEAD_INIT(name)		{ &(name), &(name) }
+#define LIST_HEAD(name)			struct list_head name = LIST_HEAD_INIT(name)
+
+static inline void INIT_LIST_HEAD(struct list_head *list)
+{
+	list->next = list;
+	list->prev = list;
+}
+
+static inline void __list_add(struct list_head *new, struct list_head *prev, struct list_head *next)
+{
+	next->prev = new;
+	new->next = next;
+	new->prev = prev;
+	prev->next = new;
+}
+
+static inline void list_add(struct list_head *new, struct list_head *head) { __list_add(new, head, head->next); }
+static inline void list_add_tail(struct list_head *new, struct list_head *head) { __list_add(new, head->prev, head); }
+
+static inline void list_del_init(struct list_head *entry)
+{
+	entry->next->prev = entry->prev;
+	entry->prev->next = entry->next;
+	INIT_LIST_HEAD(entry);
+}
+
+#define list_del(entry)			list_del_init(entry)
+static inline int list_empty(const struct list_head *head) { return head->next == head; }
+
+#define list_entry(ptr, type, member)	container_of(ptr, type, member)
+#define list_for_each_entry(pos, head, member)					\
+	for (pos = list_entry((head)->next, typeof(*pos), member);		\
+	     &pos->member != (head);						\
+	     pos = list_entry(pos->member.next, typeof(*pos), member))
+#define list_for_each_entry_safe(pos, n, head, member)				\
+	for (pos = list_entry((head)->next, typeof(*pos), member),		\
+	     n = list_entry(pos->member.next, typeof(*pos), member);		\
+	     &pos->member != (head);						\
+	     pos = n, n = list_entry(n->member.next, typeof(*n), member))
+
+/* locking, the harness is single threaded */
+struct mutex {
+	int locked;
+};
+
+#define DEFINE_MUTEX(name)		struct mutex name = { 0 }
+#define MAX_LOCKDEP_SUBCLASSES		8
+#define lockdep_is_held(lock)		1
+static inline void mutex_init(struct mutex *lock) { lock->locked = 0; }
+static inline void mutex_lock(struct mutex *lock) { lock->locked++; }
+static inline void mutex_lock_nested(struct mutex *lock, unsigned int subclass) { lock->locked++; }
+static inline void mutex_unlock(struct mutex *lock) { lock->locked--; }
+
+struct rw_semaphore {
+	int locked;
+};
+
+static inline int down_write_trylock(struct rw_semaphore *sem) { return sem->locked ? 0 : ++sem->locked; }
+static inline void up_write(struct rw_semaphore *sem) { sem->locked--; }
+
+typedef struct {
+	int locked;
+} spinlock_t;
+
+#define DEFINE_SPINLOCK(name)		spinlock_t name = { 0 }
+static inline void spin_lock(spinlock_t *lock) { lock->locked++; }
+static inline void spin_unlock(spinlock_t *lock) { lock->locked--; }
+#define spin_lock_irqsave(lock, flags)	do { (flags) = 0; spin_lock(lock); } while (0)
+#define spin_unlock_irqrestore(lock, flags) do { (void)(flags); spin_unlock(lock); } while (0)
+
+typedef struct {
+	int counter;
+} atomic_t;
+
+static inline int atomic_read(const atomic_t *v) { return v->counter; }
+static inline void atomic_set(atomic_t *v, int i) { v->counter = i; }
+static inline void atomic_inc(atomic_t *v) { v->counter++; }
+static inline int atomic_xchg(atomic_t *v, int i) { int old = v->counter; v->counter = i; return old; }
+
+/* rcu, readers and the writer never run concurrently in the harness */
+struct rcu_head {
+	void *next;
+};
+
+#define rcu_read_lock()			do { } while (0)
+#define rcu_read_unlock()		do { } while (0)
+#define rcu_dereference(p)		(p)
+#define rcu_dereference_protected(p, c)	(p)
+#define rcu_access_pointer(p)		(p)
+#define rcu_assign_pointer(p, v)	((p) = (v))
+#define RCU_INIT_POINTER(p, v)		((p) = (v))
+static inline void synchronize_rcu(void) { }
+
+/* work, queued work is never run by the harness */
+struct work_struct {
+	void (*func)(struct work_struct *work);
+};
+
+typedef void (*work_func_t)(struct work_struct *work);
+#define INIT_WORK(w, f)			((w)->func = (f))
+#define DECLARE_WORK(n, f)		struct work_struct n = { .func = (f) }
+struct workqueue_struct;
+#define system_highpri_wq		((struct workqueue_struct *)NULL)
+#define system_power_efficient_wq	((struct workqueue_struct *)NULL)
+static inline bool queue_work(struct workqueue_struct *wq, struct work_struct *work) { return true; }
+static inline bool schedule_work(struct work_struct *work) { return true; }
+static inline bool cancel_work_sync(struct work_struct *work) { return false; }
+static inline bool flush_work(struct work_struct *work) { return false; }
+
+/* cpus */
+#define NR_CPUS				8
+
+struct cpumask {
+	unsigned long bits[1];
+};
+
+typedef struct cpumask cpumask_var_t[1];
+#define nr_cpu_ids			NR_CPUS
+static struct cpumask zz_stub_online_mask = { { (1UL << NR_CPUS) - 1 } };
+static const struct cpumask *const cpu_online_mask = &zz_stub_online_mask;
+
+static inline bool cpumask_test_cpu(int cpu, const struct cpumask *mask) { return mask->bits[0] & (1UL << cpu); }
+static inline void cpumask_set_cpu(unsigned int cpu, struct cpumask *mask) { mask->bits[0] |= 1UL << cpu; }
+static inline void cpumask_clear_cpu(int cpu, struct cpumask *mask) { mask->bits[0] &= ~(1UL << cpu); }
+static inline void cpumask_clear(struct cpumask *mask) { mask->bits[0] = 0; }
+static inline unsigned int cpumask_weight(const struct cpumask *mask) { return __builtin_popcountl(mask->bits[0]); }
+static inline bool cpumask_empty(const struct cpumask *mask) { return !mask->bits[0]; }
+static inline void cpumask_copy(struct cpumask *dst, const struct cpumask *src) { *dst = *src; }
+
+static inline bool cpumask_intersects(const struct cpumask *src1, const struct cpumask *src2)
+{
+	return src1->bits[0] & src2->bits[0];
+}
+
+static inline void cpumask_or(struct cpumask *dst, const struct cpumask *src1, const struct cpumask *src2)
+{
+	dst->bits[0] = src1->bits[0] | src2->bits[0];
+}
+
+static inline void cpumask_andnot(struct cpumask *dst, const struct cpumask *src1, const struct cpumask *src2)
+{
+	dst->bits[0] = src1->bits[0] & ~src2->bits[0];
+}
+
+static inline bool cpumask_test_and_clear_cpu(int cpu, struct cpumask *mask)
+{
+	bool ret = cpumask_test_cpu(cpu, mask);
+
+	cpumask_clear_cpu(cpu, mask);
+	return ret;
+}
+
+#define for_each_cpu(cpu, mask)							\
+	for ((cpu) = 0; (cpu) < NR_CPUS; (cpu)++)				\
+		if (!cpumask_test_cpu(cpu, mask)) { } else
+#define for_each_online_cpu(cpu)	for_each_cpu(cpu, cpu_online_mask)
+#define for_each_possible_cpu(cpu)	for ((cpu) = 0; (cpu) < NR_CPUS; (cpu)++)
+#define cpu_online(cpu)			cpumask_test_cpu(cpu, cpu_online_mask)
+#define cpu_possible(cpu)		((unsigned int)(cpu) < NR_CPUS)
+static inline unsigned int num_online_cpus(void) { return cpumask_weight(cpu_online_mask); }
+static inline int smp_processor_id(void) { return 0; }
+static inline bool cpu_is_hotpluggable(unsigned int cpu) { return cpu != 0; }
+static inline int cpu_up(unsigned int cpu) { cpumask_set_cpu(cpu, &zz_stub_online_mask); return 0; }
+static inline int cpu_down(unsigned int cpu) { cpumask_clear_cpu(cpu, &zz_stub_online_mask); return 0; }
+static inline unsigned long nr_running(void) { return 1; }
+
+#define DEFINE_PER_CPU(type, name)	typeof(type) name[NR_CPUS]
+#define per_cpu(var, cpu)		((var)[cpu])
+
+/*
+ * cpu time, advanced by the harness per sample. wall and idle are in us, the idle time already includes iowait
+ * unless io_is_busy is set, like the kernel counts it
+ */
+static u64 zz_stub_wall[NR_CPUS];
+static u64 zz_stub_idle[NR_CPUS];
+static u64 zz_stub_iowait[NR_CPUS];
+
+static inline u64 get_cpu_idle_time(unsigned int cpu, u64 *wall, int io_busy)
+{
+	if (wall)
+		*wall = zz_stub_wall[cpu];
+	return io_busy ? zz_stub_idle[cpu] - zz_stub_iowait[cpu] : zz_stub_idle[cpu];
+}
+
+static inline u64 get_cpu_iowait_time_us(int cpu, u64 *last_update_time)
+{
+	if (last_update_time)
+		*last_update_time = zz_stub_wall[cpu];
+	return zz_stub_iowait[cpu];
+}
+
+struct kernel_cpustat {
+	u64 cpustat[10];
+};
+
+#define CPUTIME_NICE			1
+static struct kernel_cpustat zz_stub_kcpustat[NR_CPUS];
+#define kcpustat_cpu(cpu)		(zz_stub_kcpustat[cpu])
+static inline unsigned int cputime_to_usecs(u64 ct) { return ct; }
+
+/* sysfs */
+struct kobject {
+	int unused;
+};
+
+struct attribute {
+	const char *name;
+	unsigned short mode;
+};
+
+#define __ATTR(_name, _mode, _show, _store) { .attr = { .name = #_name, .mode = _mode }, .show = _show, .store = _store }
+
+/* debugfs and mmap, not available in the harness */
+struct seq_file {
+	void *private;
+};
+
+struct inode {
+	void *i_private;
+};
+
+struct file {
+	void *private_data;
+};
+
+struct vm_area_struct {
+	unsigned long vm_start, vm_end, vm_pgoff;
+};
+
+struct file_operations {
+	void *owner;
+	int (*open)(struct inode *, struct file *);
+	ssize_t (*read)(struct file *, char __user *, size_t, loff_t *);
+	ssize_t (*write)(struct file *, const char __user *, size_t, loff_t *);
+	loff_t (*llseek)(struct file *, loff_t, int);
+	int (*release)(struct inode *, struct file *);
+	int (*mmap)(struct file *, struct vm_area_struct *);
+};
+
+struct dentry {
+	int unused;
+};
+
+static inline void seq_printf(struct seq_file *m, const char *fmt, ...) { }
+static inline void seq_puts(struct seq_file *m, const char *s) { }
+static inline int single_open(struct file *file, int (*show)(struct seq_file *, void *), void *data) { return 0; }
+static inline int single_release(struct inode *inode, struct file *file) { return 0; }
+static inline ssize_t seq_read(struct file *file, char __user *buf, size_t size, loff_t *ppos) { return 0; }
+static inline loff_t seq_lseek(struct file *file, loff_t offset, int whence) { return 0; }
+static inline struct dentry *debugfs_create_dir(const char *name, struct dentry *parent) { return NULL; }
+static inline struct dentry *debugfs_create_file(const char *name, unsigned short mode, struct dentry *parent,
+	void *data, const struct file_operations *fops) { return NULL; }
+static inline void debugfs_remove_recursive(struct dentry *dentry) { }
+static inline int remap_vmalloc_range(struct vm_area_struct *vma, void *addr, unsigned long pgoff) { return -ENODEV; }
+
+static inline unsigned long copy_from_user(void *to, const void __user *from, unsigned long n)
+{
+	memcpy(to, from, n);
+	return 0;
+}
+
+/* input */
+struct input_dev {
+	const char *name;
+};
+
+struct input_handler;
+
+struct input_handle {
+	struct input_dev *dev;
+	struct input_handler *handler;
+	const char *name;
+	void *private;
+};
+
+struct input_device_id {
+	unsigned long flags;
+	unsigned long evbit[1];
+	unsigned long absbit[1];
+	unsigned long keybit[12];
+	unsigned long driver_info;
+};
+
+struct input_handler {
+	void (*event)(struct input_handle *, unsigned int, unsigned int, int);
+	int (*connect)(struct input_handler *, struct input_dev *, const struct input_device_id *);
+	void (*disconnect)(struct input_handle *);
+	const char *name;
+	const struct input_device_id *id_table;
+};
+
+#define INPUT_DEVICE_ID_MATCH_EVBIT	0x0010
+#define INPUT_DEVICE_ID_MATCH_KEYBIT	0x0080
+#define INPUT_DEVICE_ID_MATCH_ABSBIT	0x0200
+#define EV_KEY				0x01
+#define EV_ABS				0x03
+#define ABS_X				0x00
+#define ABS_Y				0x01
+#define ABS_MT_POSITION_X		0x35
+#define ABS_MT_POSITION_Y		0x36
+#define KEY_A				30
+#define BTN_TOUCH			0x14a
+#define BITS_PER_LONG			64
+#define BIT_MASK(nr)			(1UL << ((nr) % BITS_PER_LONG))
+#define BIT_WORD(nr)			((nr) / BITS_PER_LONG)
+static inline int input_register_handle(struct input_handle *handle) { return 0; }
+static inline void input_unregister_handle(struct input_handle *handle) { }
+static inline int input_open_device(struct input_handle *handle) { return 0; }
+static inline void input_close_device(struct input_handle *handle) { }
+
+/* registered input handlers */
+static int zz_stub_input_handlers;
+
+static inline int input_register_handler(struct input_handler *handler) { zz_stub_input_handlers++; return 0; }
+static inline void input_unregister_handler(struct input_handler *handler) { zz_stub_input_handlers--; }
+
+/* thermal, one zone named "zz_stub" with the temperature set by the harness, it can be unregistered */
+#define THERMAL_NAME_LENGTH		20
+
+struct thermal_zone_device {
+	int temperature;
+	bool unregistered;
+};
+
+static struct thermal_zone_device zz_stub_tz;
+
+static inline struct thermal_zone_device *thermal_zone_get_zone_by_name(const char *name)
+{
+	return strcmp(name, "zz_stub") || zz_stub_tz.unregistered ? ERR_PTR(-ENODEV) : &zz_stub_tz;
+}
+
+static inline int thermal_zone_get_temp(struct thermal_zone_device *tz, int *temp)
+{
+	*temp = tz->temperature;
+	return 0;
+}
+
+#endif /* _ZZ_KERNEL_H */
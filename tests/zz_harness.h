@@ -0,0 +1,179 @@
+/*
+ *  tests/zz_harness.h
+ *
+ *  Userspace harness for the zzmoove governor. the governor source is built as it is against the stubs in include/
+ *  and one policy is driven like the governor core would do it: the harness sets up the dbs data and the policy,
+ *  advances the cpu times by the loads of a sample and calls the sampling path of the governor
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef _ZZ_HARNESS_H
+#define _ZZ_HARNESS_H
+
+#include "cpufreq_zzmoove.c"
+
+struct zz_harness {
+	struct dbs_data dbs_data;
+	struct cpufreq_policy policy;
+	struct policy_dbs_info *policy_dbs;
+	struct zz_policy_dbs_info *dbs_info;
+	struct cpufreq_frequency_table table[MAX_FREQ_TABLE_SIZE * 2 + 1];
+};
+
+// tunables snapshot as seen by the sampling path
+static inline struct zz_dbs_tuners *zz_harness_snap(struct zz_harness *h)
+{
+	return &((struct zz_dbs_tuners *)h->dbs_data.tuners)->snap->tuners;
+}
+
+static struct governor_attr *zz_harness_attr(const char *name)
+{
+	struct attribute **attr;
+
+	for (attr = zz_attributes; *attr; attr++) {
+		if (!strcmp((*attr)->name, name))
+			return container_of(*attr, struct governor_attr, attr);
+	}
+
+	fprintf(stderr, "zz_harness: no tunable '%s'\n", name);
+	exit(2);
+}
+
+// write a tunable like sysfs does, returns the result of the store function
+static ssize_t zz_harness_store(struct zz_harness *h, const char *name, const char *buf)
+{
+	struct governor_attr *attr = zz_harness_attr(name);
+
+	return attr->store(&h->dbs_data.attr_set, buf, strlen(buf));
+}
+
+// read a tunable like sysfs does into buf (at least PAGE_SIZE)
+static ssize_t zz_harness_show(struct zz_harness *h, const char *name, char *buf)
+{
+	struct governor_attr *attr = zz_harness_attr(name);
+
+	return attr->show(&h->dbs_data.attr_set, buf);
+}
+
+/*
+ * set up dbs data and one policy with the given frequency table (CPUFREQ_ENTRY_INVALID entries allowed) and cpus,
+ * the policy limits are taken from the lowest and highest valid frequency unless given (0 = from table)
+ */
+static int zz_harness_init(struct zz_harness *h, const unsigned int *freqs, unsigned int cnt, unsigned int cpus,
+	unsigned int min, unsigned int max)
+{
+	unsigned int lowest = UINT_MAX, highest = 0;
+	unsigned int i;
+	int ret;
+
+	memset(h, 0, sizeof(*h));
+	memset(zz_stub_wall, 0, sizeof(zz_stub_wall));
+	memset(zz_stub_idle, 0, sizeof(zz_stub_idle));
+	memset(zz_stub_iowait, 0, sizeof(zz_stub_iowait));
+	memset(zz_stub_cpu_dbs, 0, sizeof(zz_stub_cpu_dbs));
+	zz_stub_transitions = 0;
+	zz_stub_fast_switch_count = 0;
+
+	if (!cnt || cnt > ARRAY_SIZE(h->table) - 1 || !cpus || cpus > NR_CPUS)
+		return -EINVAL;
+
+	for (i = 0; i < cnt; i++) {
+		h->table[i].frequency = freqs[i];
+		if (freqs[i] == CPUFREQ_ENTRY_INVALID)
+			continue;
+		lowest = min(lowest, freqs[i]);
+		highest = max(highest, freqs[i]);
+	}
+	h->table[cnt].frequency = CPUFREQ_TABLE_END;
+
+	if (!highest)
+		return -EINVAL;
+
+	for (i = 0; i < cpus; i++) {
+		cpumask_set_cpu(i, h->policy.cpus);
+		cpumask_set_cpu(i, h->policy.related_cpus);
+	}
+
+	h->policy.cpu = 0;
+	h->policy.cpuinfo.min_freq = lowest;
+	h->policy.cpuinfo.max_freq = highest;
+	h->policy.cpuinfo.transition_latency = 20000;
+	h->policy.min = min ? min : lowest;
+	h->policy.max = max ? max : highest;
+	h->policy.cur = h->policy.min;
+	h->policy.freq_table = h->table;
+
+	INIT_LIST_HEAD(&h->dbs_data.attr_set.policy_list);
+	ret = zz_init(&h->dbs_data);
+	if (ret)
+		return ret;
+
+	// the core default, transition latency in us times the latency multiplier but not below the min rate
+	h->dbs_data.sampling_rate = max(h->dbs_data.min_sampling_rate,
+		h->policy.cpuinfo.transition_latency / 1000 * LATENCY_MULTIPLIER);
+
+	h->policy_dbs = zz_alloc();
+	if (!h->policy_dbs) {
+		zz_exit(&h->dbs_data);
+		return -ENOMEM;
+	}
+
+	h->dbs_info = to_dbs_info(h->policy_dbs);
+	h->policy_dbs->policy = &h->policy;
+	h->policy_dbs->dbs_data = &h->dbs_data;
+	h->policy.governor_data = h->policy_dbs;
+	list_add(&h->policy_dbs->list, &h->dbs_data.attr_set.policy_list);
+
+	h->policy_dbs->rate_mult = 1;
+	gov_update_cpu_data(&h->dbs_data);
+	zz_start(&h->policy);
+	return 0;
+}
+
+static void zz_harness_exit(struct zz_harness *h)
+{
+	list_del_init(&h->policy_dbs->list);
+	zz_exit(&h->dbs_data);
+	zz_free(h->policy_dbs);
+	h->policy.governor_data = NULL;
+}
+
+// account wall_us of time to a cpu, busy_us of it not idle
+static inline void zz_harness_advance(unsigned int cpu, u64 wall_us, u64 busy_us)
+{
+	zz_stub_wall[cpu] += wall_us;
+	zz_stub_idle[cpu] += wall_us - min(busy_us, wall_us);
+}
+
+// run the sampling path after period_us of time passed, returns the delay until the next sample in us
+static unsigned int zz_harness_run(struct zz_harness *h, u64 period_us)
+{
+	zz_stub_now += period_us * NSEC_PER_USEC;
+	h->policy_dbs->last_sample_time = zz_stub_now;
+
+	return zz_dbs_timer(&h->policy);
+}
+
+/*
+ * run one sample covering period_us with the given load of each cpu (a single load is used for all cpus),
+ * returns the delay until the next sample as requested by the governor
+ */
+static unsigned int zz_harness_sample(struct zz_harness *h, const unsigned int *loads, unsigned int cnt,
+	unsigned int period_us)
+{
+	unsigned int cpu, n = 0;
+
+	for_each_cpu(cpu, h->policy.cpus) {
+		unsigned int load = min(loads[cnt > 1 ? min(n, cnt - 1) : 0], 100U);
+
+		zz_harness_advance(cpu, period_us, (u64)period_us * load / 100);
+		n++;
+	}
+
+	return zz_harness_run(h, period_us);
+}
+
+#endif /* _ZZ_HARNESS_H */
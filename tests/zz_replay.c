@@ -0,0 +1,436 @@
+/*
+ *  tests/zz_replay.c
+ *
+ *  Replays a recorded load trace of one policy through the governor built on the userspace harness, so frequency
+ *  tables and tunables can be compared offline. the trace is taken as the cpu demand over time: the governor samples
+ *  it at the delays it requests itself and sees the load the demand would cause at the frequency it has chosen.
+ *  demand above the capacity of that frequency is lost and counted against the performance score
+ *
+ *  usage: zz_replay [options] trace
+ *         -f freqs		frequency table in kHz, comma separated in driver order (default 300000..1800000)
+ *         -m min, -M max	policy limits in kHz (default lowest and highest table frequency)
+ *         -c cpus		cpus of the policy (default cpus of the trace)
+ *         -r period		period in us of the first csv row (default the sampling rate)
+ *         -t name=value	write a tunable like sysfs before the replay, can be given more than once and is
+ *				applied in order (eg. -t profile=battery -t up_threshold=80)
+ *         -q			print the summary only
+ *
+ *  the trace is either a sample ring dump or csv. a ring dump starts with the ring header (struct zz_ring_header)
+ *  and the records (struct zz_ring_record) follow at header_size. a file of exactly the mapped ring size is taken
+ *  as a snapshot of the whole ring and the records from tail to head are used, any other size as the header
+ *  followed by the drained records in order. csv rows are 'time_us,freq,load[,load...]' with the time at the end
+ *  of the row, the freq the loads were measured at in kHz (0 = not known, the load is then used as it is at every
+ *  freq) and the load in percent of each cpu. empty rows and rows starting with '#' or not with a number are skipped
+ *
+ *  the output is one 'time_us,load,freq' row per sample with the freq chosen by the governor, followed by the
+ *  summary as '#' rows: samples, transitions, average freq, energy and work. energy is power x time from the
+ *  opp_power tunable when set, otherwise from a power model growing with the cube of the freq (1000 at the
+ *  highest freq). work is the demand served in mega cycles and in percent of the demand of the trace
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <stdarg.h>
+#include <unistd.h>
+
+#include "zz_harness.h"
+
+#define ZZ_REPLAY_MAX_TUNABLES	(64)
+
+// ZZ: one row of the trace, load of each cpu from start to end
+struct zz_replay_seg {
+	u64 start;					// ZZ: start of the row in us
+	u64 end;					// ZZ: end of the row in us
+	unsigned int freq;				// ZZ: freq the loads were measured at (0 = not known)
+	unsigned int cpu_cnt;				// ZZ: amount of loads of the row
+	unsigned char load[NR_CPUS];			// ZZ: load of each cpu in percent
+};
+
+struct zz_replay_trace {
+	struct zz_replay_seg *seg;
+	unsigned int cnt;
+	unsigned int size;
+	unsigned int cpus;				// ZZ: highest amount of loads of all rows
+};
+
+static void zz_replay_die(const char *fmt, ...)
+{
+	va_list args;
+
+	va_start(args, fmt);
+	fprintf(stderr, "zz_replay: ");
+	vfprintf(stderr, fmt, args);
+	fprintf(stderr, "\n");
+	va_end(args);
+	exit(2);
+}
+
+static struct zz_replay_seg *zz_replay_add(struct zz_replay_trace *trace)
+{
+	if (trace->cnt == trace->size) {
+	    trace->size = trace->size ? trace->size * 2 : 1024;
+	    trace->seg = realloc(trace->seg, trace->size * sizeof(*trace->seg));
+	    if (!trace->seg)
+		zz_replay_die("out of memory");
+	}
+
+	memset(&trace->seg[trace->cnt], 0, sizeof(*trace->seg));
+	return &trace->seg[trace->cnt++];
+}
+
+// add a ring record as row, the row ends at the time of the sample and covers the sampling period ended by it
+static void zz_replay_add_record(struct zz_replay_trace *trace, const struct zz_ring_record *rec)
+{
+	struct zz_replay_seg *seg;
+	u64 end = rec->time / NSEC_PER_USEC;
+	unsigned int i;
+
+	// ZZ: the first record or a gap because samples were dropped, only the period of the record is known then
+	if (trace->cnt && trace->seg[trace->cnt - 1].end <= end
+	    && end - trace->seg[trace->cnt - 1].end <= (u64)rec->interval) {
+	    seg = zz_replay_add(trace);
+	    seg->start = trace->seg[trace->cnt - 2].end;
+	} else {
+	    seg = zz_replay_add(trace);
+	    seg->start = end - min_t(u64, end, rec->interval);
+	}
+
+	seg->end = end;
+	seg->freq = rec->cur_freq;
+	seg->cpu_cnt = rec->cpu_cnt ? min_t(unsigned int, rec->cpu_cnt, NR_CPUS) : 1;
+
+	for (i = 0; i < seg->cpu_cnt; i++)
+		seg->load[i] = min_t(unsigned int, rec->cpu_cnt ? rec->cpu_load[i] : rec->load, 100);
+
+	trace->cpus = max(trace->cpus, seg->cpu_cnt);
+}
+
+static void zz_replay_read_ring(struct zz_replay_trace *trace, const char *data, size_t size, const char *name)
+{
+	struct zz_ring_header hdr;
+	const char *rec;
+	size_t image = 0;
+	u32 i;
+
+	if (size < sizeof(hdr))
+	    zz_replay_die("%s: ring header truncated", name);
+
+	memcpy(&hdr, data, sizeof(hdr));
+
+	if (hdr.version != ZZ_RING_VERSION || hdr.record_size != sizeof(struct zz_ring_record)
+	    || hdr.header_size < sizeof(hdr) || hdr.header_size > size)
+	    zz_replay_die("%s: unsupported ring format", name);
+
+	if (hdr.records && !(hdr.records & (hdr.records - 1)))
+	    image = hdr.header_size + (size_t)hdr.records * hdr.record_size;
+
+	rec = data + hdr.header_size;
+
+	if (size == image) {
+	    if (hdr.head - hdr.tail > hdr.records)
+		zz_replay_die("%s: ring head and tail out of range", name);
+
+	    for (i = hdr.tail; i != hdr.head; i++) {
+		struct zz_ring_record r;
+
+		memcpy(&r, rec + (size_t)(i & (hdr.records - 1)) * hdr.record_size, sizeof(r));
+		zz_replay_add_record(trace, &r);
+	    }
+	    return;
+	}
+
+	for (; rec + hdr.record_size <= data + size; rec += hdr.record_size) {
+		struct zz_ring_record r;
+
+		memcpy(&r, rec, sizeof(r));
+		zz_replay_add_record(trace, &r);
+	}
+}
+
+static void zz_replay_read_csv(struct zz_replay_trace *trace, char *data, unsigned int period, const char *name)
+{
+	char *line, *next;
+	unsigned int row = 0;
+
+	for (line = data; line; line = next) {
+		struct zz_replay_seg *seg;
+		unsigned long long end;
+		unsigned int freq, load;
+		int n;
+
+		next = strchr(line, '\n');
+		if (next)
+		    *next++ = '\0';
+		row++;
+
+		line = skip_spaces(line);
+		if (!isdigit(*line))
+		    continue;
+
+		if (sscanf(line, "%llu ,%u%n", &end, &freq, &n) != 2)
+		    zz_replay_die("%s:%u: expected time_us,freq,load[,load...]", name, row);
+		line += n;
+
+		if (trace->cnt && end <= trace->seg[trace->cnt - 1].end)
+		    zz_replay_die("%s:%u: time not increasing", name, row);
+
+		seg = zz_replay_add(trace);
+		seg->start = trace->cnt > 1 ? trace->seg[trace->cnt - 2].end : end - min_t(u64, end, period);
+		seg->end = end;
+		seg->freq = freq;
+
+		while (sscanf(line, " ,%u%n", &load, &n) == 1) {
+			if (seg->cpu_cnt == NR_CPUS)
+			    zz_replay_die("%s:%u: too many cpus", name, row);
+			seg->load[seg->cpu_cnt++] = min(load, 100U);
+			line += n;
+		}
+
+		if (!seg->cpu_cnt)
+		    zz_replay_die("%s:%u: no load", name, row);
+
+		trace->cpus = max(trace->cpus, seg->cpu_cnt);
+	}
+}
+
+static void zz_replay_read(struct zz_replay_trace *trace, const char *name, unsigned int period)
+{
+	FILE *f = strcmp(name, "-") ? fopen(name, "rb") : stdin;
+	size_t size = 0, len;
+	char *data = NULL;
+	u32 magic;
+
+	if (!f)
+	    zz_replay_die("%s: cannot open", name);
+
+	do {
+		data = realloc(data, size + 65536 + 1);
+		if (!data)
+		    zz_replay_die("out of memory");
+		len = fread(data + size, 1, 65536, f);
+		size += len;
+	} while (len);
+
+	if (ferror(f))
+	    zz_replay_die("%s: read error", name);
+	if (f != stdin)
+	    fclose(f);
+
+	data[size] = '\0';
+
+	if (size >= sizeof(magic) && (memcpy(&magic, data, sizeof(magic)), magic == ZZ_RING_MAGIC))
+	    zz_replay_read_ring(trace, data, size, name);
+	else
+	    zz_replay_read_csv(trace, data, period, name);
+
+	free(data);
+
+	if (!trace->cnt)
+	    zz_replay_die("%s: no samples", name);
+}
+
+static int zz_replay_parse_freqs(const char *arg, unsigned int *freqs, unsigned int max_cnt)
+{
+	unsigned int cnt = 0;
+	char *end;
+
+	while (*arg) {
+		if (cnt == max_cnt)
+		    return -EINVAL;
+		freqs[cnt++] = strtoul(arg, &end, 0);
+		if (end == arg || (*end && *end != ','))
+		    return -EINVAL;
+		arg = *end ? end + 1 : end;
+	}
+
+	return cnt;
+}
+
+// power at the current freq, from the opp_power tunable when known otherwise from the cube model
+static double zz_replay_power(struct zz_harness *h)
+{
+	struct zz_policy_dbs_info *dbs_info = h->dbs_info;
+	double f = (double)h->policy.cur / h->policy.cpuinfo.max_freq;
+
+	if (dbs_info->opp_power_valid && dbs_info->freq_table_size)
+	    return dbs_info->opp_power[zz_freq_floor_index(dbs_info, h->policy.cur)];
+
+	return 1000.0 * f * f * f;
+}
+
+struct zz_replay_result {
+	unsigned long samples;
+	double freq_time;				// ZZ: freq x time in kHz x s
+	double energy;					// ZZ: power x time in s
+	double demand;					// ZZ: demand of the trace in mega cycles
+	double served;					// ZZ: demand served in mega cycles
+};
+
+/*
+ * advance the cpu times of the harness over the window from start to end at the current freq of the policy and
+ * return the highest load of the window
+ */
+static unsigned int zz_replay_window(struct zz_harness *h, const struct zz_replay_trace *trace, unsigned int *pos,
+	unsigned int cpus, u64 start, u64 end, struct zz_replay_result *res)
+{
+	double busy[NR_CPUS] = { 0 };
+	double f = h->policy.cur;
+	unsigned int i, cpu, max_load = 0;
+
+	while (*pos < trace->cnt && trace->seg[*pos].end <= start)
+		(*pos)++;
+
+	for (i = *pos; i < trace->cnt && trace->seg[i].start < end; i++) {
+		const struct zz_replay_seg *seg = &trace->seg[i];
+		double t = (double)(min(seg->end, end) - max(seg->start, start));
+
+		for (cpu = 0; cpu < cpus && cpu < seg->cpu_cnt; cpu++) {
+			double demand, served;
+
+			if (seg->freq) {
+			    // ZZ: kHz x us gives milli cycles
+			    demand = seg->load[cpu] / 100.0 * seg->freq * t;
+			    served = min(demand, f * t);
+			    busy[cpu] += served / f;
+			} else {
+			    demand = seg->load[cpu] / 100.0 * f * t;
+			    served = demand;
+			    busy[cpu] += seg->load[cpu] / 100.0 * t;
+			}
+			res->demand += demand / 1e9;
+			res->served += served / 1e9;
+		}
+	}
+
+	for (cpu = 0; cpu < cpus; cpu++) {
+		zz_harness_advance(cpu, end - start, (u64)(busy[cpu] + 0.5));
+		max_load = max(max_load, (unsigned int)(100 * busy[cpu] / (end - start)));
+	}
+
+	res->freq_time += f * (end - start) / 1e6;
+	res->energy += zz_replay_power(h) * (end - start) / 1e6;
+
+	return min(max_load, 100U);
+}
+
+static void zz_replay(struct zz_harness *h, const struct zz_replay_trace *trace, unsigned int cpus, bool quiet)
+{
+	struct zz_replay_result res = { 0 };
+	u64 begin = trace->seg[0].start, last = trace->seg[trace->cnt - 1].end;
+	u64 now = begin, end;
+	unsigned int delay = h->dbs_data.sampling_rate;
+	unsigned int pos = 0, load;
+
+	while (now < last) {
+		end = min(now + max(delay, 1U), last);
+		load = zz_replay_window(h, trace, &pos, cpus, now, end, &res);
+		delay = zz_harness_run(h, end - now);
+		now = end;
+		res.samples++;
+
+		if (!quiet)
+		    printf("%llu,%u,%u\n", now - begin, load, h->policy.cur);
+	}
+
+	printf("# samples %lu\n", res.samples);
+	printf("# transitions %lu\n", zz_stub_transitions);
+	printf("# avg_freq %.0f kHz\n", res.freq_time * 1e6 / (last - begin));
+	printf("# energy %.3f (%s x s)\n", res.energy, h->dbs_info->opp_power_valid ? "opp_power" : "model power");
+	printf("# work %.3f Mcycles served, %.2f%% of demand\n", res.served,
+		res.demand > 0 ? 100 * res.served / res.demand : 100.0);
+}
+
+static void zz_replay_usage(void)
+{
+	fprintf(stderr, "usage: zz_replay [-f freqs] [-m min] [-M max] [-c cpus] [-r period] [-t name=value]... [-q] trace\n");
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	static const unsigned int def_freqs[] = { 300000, 600000, 900000, 1200000, 1500000, 1800000 };
+	unsigned int freqs[MAX_FREQ_TABLE_SIZE * 2];
+	unsigned int freq_cnt = ARRAY_SIZE(def_freqs);
+	unsigned int min = 0, max = 0, cpus = 0, period = 0;
+	char *tunables[ZZ_REPLAY_MAX_TUNABLES];
+	unsigned int tunable_cnt = 0, i;
+	struct zz_replay_trace trace = { 0 };
+	struct zz_harness h;
+	bool quiet = false;
+	int opt, ret;
+
+	memcpy(freqs, def_freqs, sizeof(def_freqs));
+
+	while ((opt = getopt(argc, argv, "f:m:M:c:r:t:q")) != -1) {
+		switch (opt) {
+		case 'f':
+			ret = zz_replay_parse_freqs(optarg, freqs, ARRAY_SIZE(freqs));
+			if (ret <= 0)
+			    zz_replay_die("bad frequency table '%s'", optarg);
+			freq_cnt = ret;
+			break;
+		case 'm':
+			min = strtoul(optarg, NULL, 0);
+			break;
+		case 'M':
+			max = strtoul(optarg, NULL, 0);
+			break;
+		case 'c':
+			cpus = strtoul(optarg, NULL, 0);
+			if (!cpus || cpus > NR_CPUS)
+			    zz_replay_die("bad amount of cpus '%s'", optarg);
+			break;
+		case 'r':
+			period = strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			if (tunable_cnt == ZZ_REPLAY_MAX_TUNABLES || !strchr(optarg, '='))
+			    zz_replay_die("bad tunable '%s'", optarg);
+			tunables[tunable_cnt++] = optarg;
+			break;
+		case 'q':
+			quiet = true;
+			break;
+		default:
+			zz_replay_usage();
+		}
+	}
+
+	if (optind != argc - 1)
+	    zz_replay_usage();
+
+	// ZZ: the harness is needed for the default period of the first csv row, so the trace is read after the setup
+	ret = zz_harness_init(&h, freqs, freq_cnt, cpus ? cpus : 1, min, max);
+	if (ret)
+	    zz_replay_die("harness setup failed, check the frequency table and limits");
+
+	zz_replay_read(&trace, argv[optind], period ? period : h.dbs_data.sampling_rate);
+
+	// ZZ: set up again with the cpus of the trace, the policy has to be complete before the tunables are written
+	if (!cpus) {
+	    zz_harness_exit(&h);
+	    ret = zz_harness_init(&h, freqs, freq_cnt, trace.cpus, min, max);
+	    if (ret)
+		zz_replay_die("harness setup failed");
+	}
+
+	for (i = 0; i < tunable_cnt; i++) {
+		char *val = strchr(tunables[i], '=');
+
+		*val++ = '\0';
+		ret = zz_harness_store(&h, tunables[i], val);
+		if (ret < 0)
+		    zz_replay_die("%s=%s: %s", tunables[i], val, strerror(-ret));
+	}
+
+	// ZZ: the power table is picked up at the first sample otherwise, the first window would use the model power
+	zz_evaluate_opp_power(h.dbs_info, zz_harness_snap(&h));
+
+	zz_replay(&h, &trace, cpus ? cpus : trace.cpus, quiet);
+
+	zz_harness_exit(&h);
+	free(trace.seg);
+	return 0;
+}
@@ -0,0 +1,850 @@
+/*
+ *  tests/zz_test.c
+ *
+ *  Userspace tests of the zzmoove governor helpers and a timing loop of the sampling path. the kernel has no kunit
+ *  in 4.9, so the governor source is built against the stubs in include/ and checked here directly
+ *
+ *  usage: zz_test		run all tests, exit status 1 on failures
+ *         zz_test bench [n]	time n samples (default 200000) per table size and scaling mode
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <time.h>
+
+#include "zz_harness.h"
+
+#define INV	CPUFREQ_ENTRY_INVALID
+
+static unsigned int zz_checks, zz_failures;
+
+#define CHECK(cond)								\
+do {										\
+	zz_checks++;								\
+	if (!(cond)) {								\
+		zz_failures++;							\
+		fprintf(stderr, "%s:%d: %s: check failed: %s\n",		\
+			__FILE__, __LINE__, __func__, #cond);			\
+	}									\
+} while (0)
+
+#define CHECK_EQ(a, b)								\
+do {										\
+	long long __a = (a), __b = (b);						\
+	zz_checks++;								\
+	if (__a != __b) {							\
+		zz_failures++;							\
+		fprintf(stderr, "%s:%d: %s: %s == %lld, expected %s == %lld\n",	\
+			__FILE__, __LINE__, __func__, #a, __a, #b, __b);	\
+	}									\
+} while (0)
+
+#define STORE_OK(h, name, buf)	CHECK_EQ(zz_harness_store(h, name, buf), (ssize_t)strlen(buf))
+
+static const unsigned int asc[] = { 300000, 600000, 900000, 1200000, 1500000, 1800000 };
+static const unsigned int desc[] = { 1800000, 1500000, 1200000, 900000, 600000, 300000 };
+static const unsigned int sparse[] = { INV, 300000, INV, 600000, 900000, INV, 1200000, 1500000, 1800000, INV };
+static const unsigned int dup[] = { 300000, 300000, 600000, 900000, 900000, 1200000, 1500000, 1800000, 1800000 };
+static const unsigned int oc[] = { 2400000, 2100000, 1800000, 1500000, 1200000, 900000, 600000, 300000 };
+
+static void init(struct zz_harness *h, const unsigned int *freqs, unsigned int cnt, unsigned int min,
+	unsigned int max)
+{
+	if (zz_harness_init(h, freqs, cnt, 1, min, max)) {
+		fprintf(stderr, "zz_test: harness setup failed\n");
+		exit(2);
+	}
+}
+
+static void set_cur(struct zz_harness *h, unsigned int freq)
+{
+	h->policy.cur = freq;
+	h->dbs_info->requested_freq = freq;
+}
+
+// all tables of the same frequencies end up in the same scaling index, whatever order or gaps they have
+static void test_tables(void)
+{
+	static const struct {
+		const char *name;
+		const unsigned int *freqs;
+		unsigned int cnt;
+	} tables[] = {
+		{ "ascending", asc, ARRAY_SIZE(asc) },
+		{ "descending", desc, ARRAY_SIZE(desc) },
+		{ "sparse", sparse, ARRAY_SIZE(sparse) },
+		{ "duplicate", dup, ARRAY_SIZE(dup) },
+		{ "overclocked", oc, ARRAY_SIZE(oc) },
+	};
+	struct zz_harness h;
+	unsigned int t, i;
+
+	for (t = 0; t < ARRAY_SIZE(tables); t++) {
+		// overclock steps are in the table but above the policy max until the limit is raised
+		init(&h, tables[t].freqs, tables[t].cnt, 0, 1800000);
+
+		CHECK_EQ(h.dbs_info->freq_table_size, tables[t].freqs == oc ? 8 : 6);
+		for (i = 0; i < ARRAY_SIZE(asc); i++)
+			CHECK_EQ(h.dbs_info->freq_index[i], asc[i]);
+		for (i = 1; i < h.dbs_info->freq_table_size; i++)
+			CHECK(h.dbs_info->freq_index[i - 1] < h.dbs_info->freq_index[i]);
+
+		CHECK_EQ(h.dbs_info->min_scaling_freq_hard, 0);
+		CHECK_EQ(h.dbs_info->max_scaling_freq_hard, 5);
+		CHECK_EQ(h.dbs_info->max_scaling_freq_soft, 5);
+		CHECK_EQ(h.dbs_info->cur_freq_index, 0);
+		CHECK_EQ(zz_get_freq_index(h.dbs_info, 1200000), 3);
+		CHECK_EQ(zz_get_freq_index(h.dbs_info, 1000000), -1);
+
+		if (tables[t].freqs == oc) {
+			CHECK_EQ(h.dbs_info->freq_index[6], 2100000);
+			CHECK_EQ(h.dbs_info->freq_index[7], 2400000);
+
+			// raising the limit makes the overclock steps available without rebuilding the index
+			h.policy.max = 2400000;
+			set_cur(&h, 1800000);
+			zz_harness_sample(&h, (unsigned int []){ 100 }, 1, h.dbs_data.sampling_rate);
+			CHECK_EQ(h.dbs_info->max_scaling_freq_hard, 7);
+			CHECK_EQ(h.policy.cur, 2400000);
+		}
+
+		zz_harness_exit(&h);
+	}
+
+	// a table of invalid entries only leaves the index empty
+	init(&h, (unsigned int []){ 300000 }, 1, 0, 0);
+	h.table[0].frequency = INV;
+	zz_start(&h.policy);
+	CHECK_EQ(h.dbs_info->freq_table_size, 0);
+	CHECK_EQ(zz_get_freq_index(h.dbs_info, 300000), -1);
+	zz_harness_exit(&h);
+}
+
+static unsigned int linear_floor(struct zz_policy_dbs_info *dbs_info, unsigned int freq)
+{
+	unsigned int i, ret = 0;
+
+	for (i = 0; i < dbs_info->freq_table_size; i++) {
+		if (dbs_info->freq_index[i] <= freq)
+			ret = i;
+	}
+	return ret;
+}
+
+static unsigned int linear_ceil(struct zz_policy_dbs_info *dbs_info, unsigned int freq)
+{
+	unsigned int i;
+
+	for (i = 0; i < dbs_info->freq_table_size; i++) {
+		if (dbs_info->freq_index[i] >= freq)
+			return i;
+	}
+	return dbs_info->freq_table_size - 1;
+}
+
+static void test_floor_ceil(void)
+{
+	unsigned int freqs[MAX_FREQ_TABLE_SIZE];
+	struct zz_harness h;
+	unsigned int n, i, f;
+
+	init(&h, asc, ARRAY_SIZE(asc), 0, 0);
+	CHECK_EQ(zz_freq_floor_index(h.dbs_info, 300000), 0);
+	CHECK_EQ(zz_freq_floor_index(h.dbs_info, 100000), 0);
+	CHECK_EQ(zz_freq_floor_index(h.dbs_info, 750000), 1);
+	CHECK_EQ(zz_freq_floor_index(h.dbs_info, 1799999), 4);
+	CHECK_EQ(zz_freq_floor_index(h.dbs_info, 1800000), 5);
+	CHECK_EQ(zz_freq_floor_index(h.dbs_info, UINT_MAX), 5);
+	CHECK_EQ(zz_freq_ceil_index(h.dbs_info, 0), 0);
+	CHECK_EQ(zz_freq_ceil_index(h.dbs_info, 300001), 1);
+	CHECK_EQ(zz_freq_ceil_index(h.dbs_info, 600000), 1);
+	CHECK_EQ(zz_freq_ceil_index(h.dbs_info, 750000), 2);
+	CHECK_EQ(zz_freq_ceil_index(h.dbs_info, 1800000), 5);
+	CHECK_EQ(zz_freq_ceil_index(h.dbs_info, UINT_MAX), 5);
+	zz_harness_exit(&h);
+
+	// every table size up to the max against a linear search, probing on, between and outside of the steps
+	for (n = 1; n <= MAX_FREQ_TABLE_SIZE; n++) {
+		for (i = 0; i < n; i++)
+			freqs[i] = 100000 + i * 50000;
+		init(&h, freqs, n, 0, 0);
+		CHECK_EQ(h.dbs_info->freq_table_size, n);
+
+		for (f = 50000; f <= 100000 + n * 50000; f += 25000) {
+			CHECK_EQ(zz_freq_floor_index(h.dbs_info, f), linear_floor(h.dbs_info, f));
+			CHECK_EQ(zz_freq_ceil_index(h.dbs_info, f), linear_ceil(h.dbs_info, f));
+		}
+		zz_harness_exit(&h);
+	}
+}
+
+static void test_next_freq(void)
+{
+	struct zz_harness h;
+	u64 fallbacks;
+
+	init(&h, asc, ARRAY_SIZE(asc), 0, 0);
+
+	// mode 0, one step, two above smooth up and capped at the soft limit
+	CHECK_EQ(zz_get_next_freq(600000, 1, 70, 80, &h.policy, zz_harness_snap(&h)), 900000);
+	CHECK_EQ(zz_get_next_freq(600000, 1, 80, 80, &h.policy, zz_harness_snap(&h)), 1200000);
+	CHECK_EQ(zz_get_next_freq(1500000, 1, 90, 80, &h.policy, zz_harness_snap(&h)), 1800000);
+	CHECK_EQ(zz_get_next_freq(1800000, 1, 90, 80, &h.policy, zz_harness_snap(&h)), 1800000);
+	CHECK_EQ(zz_get_next_freq(900000, 0, 10, 80, &h.policy, zz_harness_snap(&h)), 600000);
+	CHECK_EQ(zz_get_next_freq(300000, 0, 10, 80, &h.policy, zz_harness_snap(&h)), 300000);
+	CHECK_EQ(h.dbs_info->cur_freq_index, 0);
+
+	zz_update_soft_limit(h.dbs_info, 1200000);
+	CHECK_EQ(zz_get_next_freq(900000, 1, 90, 80, &h.policy, zz_harness_snap(&h)), 1200000);
+	zz_update_soft_limit(h.dbs_info, 0);
+
+	// static fast scaling
+	STORE_OK(&h, "fast_scaling_up", "2");
+	STORE_OK(&h, "fast_scaling_down", "1");
+	CHECK_EQ(zz_get_next_freq(300000, 1, 50, 80, &h.policy, zz_harness_snap(&h)), 1200000);
+	CHECK_EQ(zz_get_next_freq(1500000, 0, 10, 80, &h.policy, zz_harness_snap(&h)), 900000);
+	CHECK_EQ(zz_get_next_freq(600000, 0, 10, 80, &h.policy, zz_harness_snap(&h)), 300000);
+
+	// auto fast scaling replaces the static levels by the ones of the policy
+	STORE_OK(&h, "afs_up", "1");
+	STORE_OK(&h, "afs_down", "1");
+	h.dbs_info->afs_scaling_up = 3;
+	h.dbs_info->afs_scaling_down = 0;
+	CHECK_EQ(zz_get_next_freq(300000, 1, 50, 80, &h.policy, zz_harness_snap(&h)), 1500000);
+	CHECK_EQ(zz_get_next_freq(1500000, 0, 10, 80, &h.policy, zz_harness_snap(&h)), 1200000);
+	STORE_OK(&h, "afs_up", "0");
+	STORE_OK(&h, "afs_down", "0");
+	STORE_OK(&h, "fast_scaling_up", "0");
+	STORE_OK(&h, "fast_scaling_down", "0");
+
+	// mode 1, the lower of table step and proportional target (300000 + load * 15000)
+	STORE_OK(&h, "scaling_proportional", "1");
+	CHECK_EQ(zz_get_next_freq(300000, 1, 50, 80, &h.policy, zz_harness_snap(&h)), 600000);
+	CHECK_EQ(zz_get_next_freq(1200000, 1, 50, 80, &h.policy, zz_harness_snap(&h)), 1050000);
+	CHECK_EQ(zz_get_next_freq(1200000, 0, 10, 80, &h.policy, zz_harness_snap(&h)), 450000);
+
+	// mode 2, proportional target only
+	STORE_OK(&h, "scaling_proportional", "2");
+	CHECK_EQ(zz_get_next_freq(300000, 1, 40, 80, &h.policy, zz_harness_snap(&h)), 900000);
+	CHECK_EQ(zz_get_next_freq(1800000, 0, 0, 80, &h.policy, zz_harness_snap(&h)), 300000);
+	CHECK_EQ(zz_get_next_freq(300000, 1, 100, 80, &h.policy, zz_harness_snap(&h)), 1800000);
+
+	// mode 3, proportional target with pol_min in the dead band (pol_max / 100 * load not above pol_min)
+	STORE_OK(&h, "scaling_proportional", "3");
+	CHECK_EQ(zz_get_next_freq(900000, 0, 10, 80, &h.policy, zz_harness_snap(&h)), 300000);
+	CHECK_EQ(zz_get_next_freq(900000, 0, 16, 80, &h.policy, zz_harness_snap(&h)), 300000);
+	CHECK_EQ(zz_get_next_freq(900000, 0, 17, 80, &h.policy, zz_harness_snap(&h)), 555000);
+	CHECK_EQ(zz_get_next_freq(300000, 1, 50, 80, &h.policy, zz_harness_snap(&h)), 1050000);
+
+	// mode 4 without power table works like mode 0, with one it goes by energy (see test_energy_freq)
+	STORE_OK(&h, "scaling_proportional", "4");
+	CHECK(!h.dbs_info->opp_power_valid);
+	CHECK_EQ(zz_get_next_freq(600000, 1, 70, 80, &h.policy, zz_harness_snap(&h)), 900000);
+	CHECK_EQ(zz_get_next_freq(900000, 0, 10, 80, &h.policy, zz_harness_snap(&h)), 600000);
+
+	// a current freq not in the table falls back to the proportional target
+	STORE_OK(&h, "scaling_proportional", "0");
+	fallbacks = h.dbs_info->stats.table_fallbacks;
+	CHECK_EQ(zz_get_next_freq(700000, 1, 60, 80, &h.policy, zz_harness_snap(&h)), 1200000);
+	CHECK_EQ(h.dbs_info->stats.table_fallbacks, fallbacks + 1);
+
+	zz_harness_exit(&h);
+}
+
+static void test_limits(void)
+{
+	unsigned int freqs[MAX_FREQ_TABLE_SIZE + 16];
+	struct zz_harness h;
+	unsigned int i;
+
+	init(&h, asc, ARRAY_SIZE(asc), 0, 0);
+
+	// limits on steps and between steps, min rounds up and max rounds down
+	h.dbs_info->pol_min = 600000;
+	h.dbs_info->pol_max = 1500000;
+	zz_update_limits(h.dbs_info);
+	CHECK_EQ(h.dbs_info->min_scaling_freq_hard, 1);
+	CHECK_EQ(h.dbs_info->max_scaling_freq_hard, 4);
+	CHECK_EQ(h.dbs_info->max_scaling_freq_soft, 4);
+
+	h.dbs_info->pol_min = 650000;
+	h.dbs_info->pol_max = 1650000;
+	zz_update_limits(h.dbs_info);
+	CHECK_EQ(h.dbs_info->min_scaling_freq_hard, 2);
+	CHECK_EQ(h.dbs_info->max_scaling_freq_hard, 4);
+
+	// the soft limit stays within the hard limits and follows them
+	zz_update_soft_limit(h.dbs_info, 1200000);
+	CHECK_EQ(h.dbs_info->max_scaling_freq_soft, 3);
+	h.dbs_info->pol_max = 900000;
+	zz_update_limits(h.dbs_info);
+	CHECK_EQ(h.dbs_info->max_scaling_freq_soft, 2);
+	h.dbs_info->pol_min = 300000;
+	h.dbs_info->pol_max = 1800000;
+	zz_update_limits(h.dbs_info);
+	CHECK_EQ(h.dbs_info->max_scaling_freq_soft, 3);
+	zz_update_soft_limit(h.dbs_info, 100000);
+	CHECK_EQ(h.dbs_info->max_scaling_freq_soft, 0);
+	zz_update_soft_limit(h.dbs_info, 0);
+	CHECK_EQ(h.dbs_info->max_scaling_freq_soft, 5);
+
+	// a limit below all steps maps to the lowest step
+	h.dbs_info->pol_max = 200000;
+	zz_update_limits(h.dbs_info);
+	CHECK_EQ(h.dbs_info->max_scaling_freq_hard, 0);
+
+	// limit changes of the policy are picked up by the sampling path
+	h.dbs_info->pol_max = 1800000;
+	zz_update_limits(h.dbs_info);
+	h.policy.max = 900000;
+	set_cur(&h, 600000);
+	zz_harness_sample(&h, (unsigned int []){ 100 }, 1, h.dbs_data.sampling_rate);
+	CHECK_EQ(h.dbs_info->pol_max, 900000);
+	CHECK_EQ(h.dbs_info->max_scaling_freq_hard, 2);
+	CHECK_EQ(h.policy.cur, 900000);
+	zz_harness_sample(&h, (unsigned int []){ 100 }, 1, h.dbs_data.sampling_rate);
+	CHECK_EQ(h.policy.cur, 900000);
+
+	h.policy.min = 1200000;
+	h.policy.max = 1800000;
+	zz_harness_sample(&h, (unsigned int []){ 0 }, 1, h.dbs_data.sampling_rate);
+	CHECK_EQ(h.dbs_info->min_scaling_freq_hard, 3);
+	CHECK(h.policy.cur >= 1200000);
+
+	// down scaling requests stop at the min limit and don't rely on the driver to clamp them
+	STORE_OK(&h, "fast_scaling_down", "3");
+	set_cur(&h, 1500000);
+	CHECK_EQ(zz_get_next_freq(1500000, 0, 0, 80, &h.policy, zz_harness_snap(&h)), 1200000);
+	zz_harness_sample(&h, (unsigned int []){ 0 }, 1, h.dbs_data.sampling_rate);
+	CHECK_EQ(h.dbs_info->requested_freq, 1200000);
+
+	zz_harness_exit(&h);
+
+	// oversized tables in any order keep the lowest and highest step
+	for (i = 0; i < MAX_FREQ_TABLE_SIZE + 16; i++)
+		freqs[i] = 2000000 - i * 20000;
+	init(&h, freqs, MAX_FREQ_TABLE_SIZE + 16, 0, 0);
+	CHECK_EQ(h.dbs_info->freq_table_size, MAX_FREQ_TABLE_SIZE);
+	CHECK_EQ(h.dbs_info->freq_index[0], freqs[MAX_FREQ_TABLE_SIZE + 15]);
+	CHECK_EQ(h.dbs_info->freq_index[MAX_FREQ_TABLE_SIZE - 1], 2000000);
+	CHECK_EQ(h.dbs_info->max_scaling_freq_hard, MAX_FREQ_TABLE_SIZE - 1);
+	zz_harness_exit(&h);
+
+	for (i = 0; i < MAX_FREQ_TABLE_SIZE + 16; i++)
+		freqs[i] = 400000 + i * 20000;
+	init(&h, freqs, MAX_FREQ_TABLE_SIZE + 16, 0, 0);
+	CHECK_EQ(h.dbs_info->freq_index[0], 400000);
+	CHECK_EQ(h.dbs_info->freq_index[MAX_FREQ_TABLE_SIZE - 1], freqs[MAX_FREQ_TABLE_SIZE + 15]);
+	zz_harness_exit(&h);
+}
+
+static void test_afs_level(void)
+{
+	struct zz_harness h;
+	struct zz_dbs_tuners *t;
+
+	init(&h, asc, ARRAY_SIZE(asc), 0, 0);
+	t = zz_harness_snap(&h);
+
+	// default thresholds 25, 50, 75 and 90, no extra steps on unchanged or opposite load
+	CHECK_EQ(zz_get_afs_level(50, 50, t), 0);
+	CHECK_EQ(zz_get_afs_level(40, 60, t), 0);
+	CHECK_EQ(zz_get_afs_level(0, 100, t), 0);
+	CHECK_EQ(zz_get_afs_level(75, 50, t), 0);
+	CHECK_EQ(zz_get_afs_level(76, 50, t), 1);
+	CHECK_EQ(zz_get_afs_level(100, 50, t), 1);
+	CHECK_EQ(zz_get_afs_level(100, 49, t), 2);
+	CHECK_EQ(zz_get_afs_level(100, 25, t), 2);
+	CHECK_EQ(zz_get_afs_level(100, 24, t), 3);
+	CHECK_EQ(zz_get_afs_level(100, 10, t), 3);
+	CHECK_EQ(zz_get_afs_level(100, 9, t), 4);
+	CHECK_EQ(zz_get_afs_level(100, 0, t), 4);
+
+	STORE_OK(&h, "afs_threshold1", "5");
+	STORE_OK(&h, "afs_threshold2", "10");
+	t = zz_harness_snap(&h);
+	CHECK_EQ(zz_get_afs_level(55, 50, t), 0);
+	CHECK_EQ(zz_get_afs_level(56, 50, t), 1);
+	CHECK_EQ(zz_get_afs_level(61, 50, t), 2);
+
+	// the sampling path takes the gradient against the previous load, up and down separately
+	STORE_OK(&h, "afs_up", "1");
+	STORE_OK(&h, "afs_down", "1");
+	STORE_OK(&h, "afs_threshold1", "25");
+	STORE_OK(&h, "afs_threshold2", "50");
+	zz_harness_sample(&h, (unsigned int []){ 10 }, 1, h.dbs_data.sampling_rate);
+	zz_harness_sample(&h, (unsigned int []){ 100 }, 1, h.dbs_data.sampling_rate);
+	CHECK_EQ(h.dbs_info->afs_scaling_up, 3);
+	CHECK_EQ(h.dbs_info->afs_scaling_down, 0);
+	zz_harness_sample(&h, (unsigned int []){ 40 }, 1, h.dbs_data.sampling_rate);
+	CHECK_EQ(h.dbs_info->afs_scaling_up, 0);
+	CHECK_EQ(h.dbs_info->afs_scaling_down, 2);
+
+	zz_harness_exit(&h);
+}
+
+static void test_energy_freq(void)
+{
+	char buf[PAGE_SIZE];
+	struct zz_harness h;
+
+	init(&h, asc, ARRAY_SIZE(asc), 0, 0);
+
+	/*
+	 * power per freq: 300000 and 900000 are equal so racing to 900000 costs nothing more, 600000 is worse than
+	 * 900000, all steps from 900000 on get more expensive
+	 */
+	STORE_OK(&h, "opp_power", "300000:100 600000:250 900000:300 1200000:500 1500000:900 1800000:1400\n");
+	zz_evaluate_opp_power(h.dbs_info, zz_harness_snap(&h));
+	CHECK(h.dbs_info->opp_power_valid);
+	CHECK(!h.dbs_info->opp_efficient[0]);
+	CHECK(!h.dbs_info->opp_efficient[1]);
+	CHECK(h.dbs_info->opp_efficient[2]);
+	CHECK(h.dbs_info->opp_efficient[3]);
+	CHECK(h.dbs_info->opp_efficient[4]);
+	CHECK(h.dbs_info->opp_efficient[5]);
+	zz_harness_show(&h, "opp_power", buf);
+	CHECK(!strcmp(buf, "300000:100 600000:250 900000:300 1200000:500 1500000:900 1800000:1400 \n"));
+
+	// required capacity is cur * load / up threshold, the lowest efficient step providing it wins
+	CHECK_EQ(zz_get_energy_freq(h.dbs_info, 600000, 50, 80), 900000);
+	CHECK_EQ(zz_get_energy_freq(h.dbs_info, 300000, 10, 80), 900000);
+	CHECK_EQ(zz_get_energy_freq(h.dbs_info, 1200000, 70, 80), 1200000);
+	CHECK_EQ(zz_get_energy_freq(h.dbs_info, 1200000, 81, 80), 1500000);
+	CHECK_EQ(zz_get_energy_freq(h.dbs_info, 1800000, 100, 80), 1800000);
+
+	// within the soft and hard limits
+	zz_update_soft_limit(h.dbs_info, 1500000);
+	CHECK_EQ(zz_get_energy_freq(h.dbs_info, 1500000, 100, 80), 1500000);
+	zz_update_soft_limit(h.dbs_info, 0);
+	h.dbs_info->pol_min = 1200000;
+	zz_update_limits(h.dbs_info);
+	CHECK_EQ(zz_get_energy_freq(h.dbs_info, 1200000, 10, 80), 1200000);
+	h.dbs_info->pol_min = 300000;
+	zz_update_limits(h.dbs_info);
+
+	// steps without power are never targeted unless there is nothing else below the soft limit
+	STORE_OK(&h, "opp_power", "300000:100 600000:150 1200000:500 1800000:1400");
+	zz_evaluate_opp_power(h.dbs_info, zz_harness_snap(&h));
+	CHECK(h.dbs_info->opp_efficient[1]);
+	CHECK(!h.dbs_info->opp_efficient[2]);
+	CHECK(!h.dbs_info->opp_efficient[4]);
+	CHECK_EQ(zz_get_energy_freq(h.dbs_info, 600000, 100, 80), 1200000);
+
+	// mode 4 uses it for both directions
+	STORE_OK(&h, "scaling_proportional", "4");
+	CHECK_EQ(zz_get_next_freq(600000, 1, 100, 80, &h.policy, zz_harness_snap(&h)), 1200000);
+	CHECK_EQ(zz_get_next_freq(1800000, 0, 10, 80, &h.policy, zz_harness_snap(&h)), 600000);
+
+	// with the thresholds of the actual step, 600000 * 90 / 40 needs 1500000 which has no power so 1800000
+	STORE_OK(&h, "opp_thresholds", "600000:40:20");
+	set_cur(&h, 600000);
+	zz_harness_sample(&h, (unsigned int []){ 90 }, 1, h.dbs_data.sampling_rate);
+	CHECK_EQ(h.policy.cur, 1800000);
+	STORE_OK(&h, "opp_thresholds", "\n");
+
+	// clearing the table ends energy aware scaling
+	STORE_OK(&h, "opp_power", "\n");
+	zz_evaluate_opp_power(h.dbs_info, zz_harness_snap(&h));
+	CHECK(!h.dbs_info->opp_power_valid);
+	zz_harness_show(&h, "opp_power", buf);
+	CHECK(!strcmp(buf, "\n"));
+
+	// and invalid tables are refused
+	CHECK_EQ(zz_harness_store(&h, "opp_power", "300000:0"), -EINVAL);
+	CHECK_EQ(zz_harness_store(&h, "opp_power", "300000"), -EINVAL);
+
+	zz_harness_exit(&h);
+}
+
+static void test_factor_skip(void)
+{
+	unsigned int skip = 0;
+
+	// factors 0 and 1 never skip
+	CHECK(!zz_factor_skip(&skip, 0, 1, 1));
+	CHECK(!zz_factor_skip(&skip, 1, 1, 1));
+	CHECK_EQ(skip, 0);
+
+	// factor 3 skips two samples, the third one is taken (the caller resets the count then)
+	CHECK(zz_factor_skip(&skip, 3, 1, 1));
+	CHECK(zz_factor_skip(&skip, 3, 1, 1));
+	CHECK(!zz_factor_skip(&skip, 3, 1, 1));
+	CHECK_EQ(skip, 2);
+
+	// adaptive sampling, samples weighted by their length in percent of the sampling rate
+	skip = 0;
+	CHECK(zz_factor_skip(&skip, 2, 150, 100));
+	CHECK_EQ(skip, 150);
+	CHECK(!zz_factor_skip(&skip, 2, 150, 100));
+	skip = 0;
+	CHECK(!zz_factor_skip(&skip, 2, 200, 100));
+	CHECK(zz_factor_skip(&skip, 4, 50, 100));
+	CHECK(zz_factor_skip(&skip, 4, 50, 100));
+	CHECK_EQ(skip, 100);
+}
+
+// a saturated policy raises the floors of the other clusters in the shared table but not its own
+static void test_coord_floor(void)
+{
+	struct zz_harness h;
+
+	if (zz_harness_init(&h, asc, ARRAY_SIZE(asc), 2, 0, 0)) {
+		fprintf(stderr, "zz_test: harness setup failed\n");
+		exit(2);
+	}
+
+	STORE_OK(&h, "coord_floor", "1:900000 3:1200000");
+	set_cur(&h, 1800000);
+	zz_harness_sample(&h, (unsigned int []){ 100 }, 1, h.dbs_data.sampling_rate);
+	CHECK_EQ(per_cpu(zz_coord_floor, 1), 0);
+	CHECK_EQ(per_cpu(zz_coord_floor, 3), 1200000);
+	CHECK_EQ(h.dbs_info->coord_cnt, 1);
+
+	zz_harness_sample(&h, (unsigned int []){ 0 }, 1, h.dbs_data.sampling_rate);
+	CHECK_EQ(per_cpu(zz_coord_floor, 3), 0);
+	CHECK_EQ(h.dbs_info->coord_cnt, 0);
+
+	zz_harness_exit(&h);
+}
+
+// in scheduler event mode the iowait boost moves once per sampling period and not per event
+static void test_iowait_boost(void)
+{
+	struct zz_harness h;
+	unsigned int i;
+
+	init(&h, asc, ARRAY_SIZE(asc), 0, 0);
+	STORE_OK(&h, "sampling_rate", "100000");
+	STORE_OK(&h, "sched_event_rate_limit", "20000");
+	STORE_OK(&h, "iowait_boost", "1800000");
+
+	// 5 events per period, mostly waiting for io at low load
+	for (i = 0; i < 11; i++) {
+		zz_harness_advance(0, 20000, 2000);
+		zz_stub_iowait[0] += 10000;
+		zz_harness_run(&h, 20000);
+		CHECK_EQ(h.dbs_info->iowait_boost_freq, asc[i / 5]);
+	}
+
+	zz_harness_exit(&h);
+}
+
+// a burst after stretched periods is seen right away and not hidden by the idle wakeup check of the core
+static void test_adaptive_sampling(void)
+{
+	unsigned int low = 5, high = 100;
+	unsigned int rate, delay, i;
+	struct zz_harness h;
+
+	init(&h, asc, ARRAY_SIZE(asc), 0, 0);
+	STORE_OK(&h, "adaptive_sampling", "10");
+	rate = h.dbs_data.sampling_rate;
+
+	delay = rate;
+	for (i = 0; i < 20; i++)
+		delay = zz_harness_sample(&h, &low, 1, delay);
+
+	CHECK_EQ(delay, rate * 10);
+	CHECK_EQ(h.policy_dbs->rate_mult, 10);
+	CHECK_EQ(h.policy.cur, asc[0]);
+
+	delay = zz_harness_sample(&h, &high, 1, delay);
+	CHECK(h.policy.cur > asc[0]);
+	CHECK_EQ(delay, max(rate / 2, h.dbs_data.min_sampling_rate));
+	CHECK_EQ(h.policy_dbs->rate_mult, 1);
+
+	// without adaptive sampling the multiplier stays at 1
+	STORE_OK(&h, "adaptive_sampling", "0");
+	delay = zz_harness_sample(&h, &low, 1, delay);
+	CHECK_EQ(delay, rate);
+	CHECK_EQ(h.policy_dbs->rate_mult, 1);
+
+	zz_harness_exit(&h);
+}
+
+// fast switching is only enabled on the policy while the tunable is set, as it blocks transition notifiers
+static void test_fast_switch(void)
+{
+	unsigned int high = 100;
+	struct zz_harness h;
+
+	init(&h, asc, ARRAY_SIZE(asc), 0, 0);
+	h.policy.fast_switch_possible = true;
+	zz_start(&h.policy);
+	CHECK(!h.policy.fast_switch_enabled);
+
+	STORE_OK(&h, "fast_switch", "1");
+	STORE_OK(&h, "fast_switch", "1");
+	CHECK(h.policy.fast_switch_enabled);
+	CHECK_EQ(zz_stub_fast_switch_count, 1);
+
+	zz_harness_sample(&h, &high, 1, h.dbs_data.sampling_rate);
+	CHECK(h.policy.cur > asc[0]);
+
+	// a restart keeps it enabled once
+	zz_start(&h.policy);
+	CHECK_EQ(zz_stub_fast_switch_count, 1);
+
+	STORE_OK(&h, "fast_switch", "0");
+	CHECK(!h.policy.fast_switch_enabled);
+	CHECK_EQ(zz_stub_fast_switch_count, 0);
+
+	// a busy policy is not waited for, the write fails and can be repeated
+	h.policy.rwsem.locked = 1;
+	CHECK_EQ(zz_harness_store(&h, "fast_switch", "1"), -EBUSY);
+	CHECK(!h.policy.fast_switch_enabled);
+	h.policy.rwsem.locked = 0;
+	STORE_OK(&h, "fast_switch", "1");
+	CHECK(h.policy.fast_switch_enabled);
+
+	zz_harness_exit(&h);
+	CHECK_EQ(zz_stub_fast_switch_count, 0);
+}
+
+// the input handler is registered while any governor instance is in use
+static void test_input_handler(void)
+{
+	struct dbs_data dbs_data = { };
+	struct zz_harness h;
+
+	CHECK_EQ(zz_stub_input_handlers, 0);
+	init(&h, asc, ARRAY_SIZE(asc), 0, 0);
+	CHECK_EQ(zz_stub_input_handlers, 1);
+
+	INIT_LIST_HEAD(&dbs_data.attr_set.policy_list);
+	CHECK_EQ(zz_init(&dbs_data), 0);
+	CHECK_EQ(zz_stub_input_handlers, 1);
+	zz_harness_exit(&h);
+	CHECK_EQ(zz_stub_input_handlers, 1);
+	zz_exit(&dbs_data);
+	CHECK_EQ(zz_stub_input_handlers, 0);
+}
+
+static void test_thermal_cap(void)
+{
+	struct zz_harness h;
+	struct zz_dbs_tuners *t;
+
+	init(&h, asc, ARRAY_SIZE(asc), 0, 0);
+
+	// no zone, no cap
+	h.dbs_info->thermal_temp = 100000;
+	CHECK_EQ(zz_get_thermal_cap(h.dbs_info, zz_harness_snap(&h)), 0);
+	CHECK_EQ(h.dbs_info->thermal_trip, -1);
+
+	CHECK_EQ(zz_harness_store(&h, "thermal_zone", "unknown"), -ENODEV);
+	STORE_OK(&h, "thermal_zone", "zz_stub\n");
+	CHECK_EQ(zz_harness_store(&h, "thermal_trips", "70000:1200000 60000:1500000"), -EINVAL);
+	CHECK_EQ(zz_harness_store(&h, "thermal_trips", "60000:1200000 70000:1500000"), -EINVAL);
+	STORE_OK(&h, "thermal_trips", "60000:1500000 70000:1200000 80000:600000");
+	t = zz_harness_snap(&h);
+
+	// trips become active at their temperature and stay active down to temp - hysteresis (2000)
+	h.dbs_info->thermal_temp = 50000;
+	CHECK_EQ(zz_get_thermal_cap(h.dbs_info, t), 0);
+	h.dbs_info->thermal_temp = 60000;
+	CHECK_EQ(zz_get_thermal_cap(h.dbs_info, t), 1500000);
+	h.dbs_info->thermal_temp = 72000;
+	CHECK_EQ(zz_get_thermal_cap(h.dbs_info, t), 1200000);
+	h.dbs_info->thermal_temp = 68000;
+	CHECK_EQ(zz_get_thermal_cap(h.dbs_info, t), 1200000);
+	h.dbs_info->thermal_temp = 67999;
+	CHECK_EQ(zz_get_thermal_cap(h.dbs_info, t), 1500000);
+	CHECK_EQ(h.dbs_info->thermal_trip, 0);
+	h.dbs_info->thermal_temp = 90000;
+	CHECK_EQ(zz_get_thermal_cap(h.dbs_info, t), 600000);
+	CHECK_EQ(h.dbs_info->thermal_trip, 2);
+	h.dbs_info->thermal_temp = 57000;
+	CHECK_EQ(zz_get_thermal_cap(h.dbs_info, t), 0);
+	CHECK_EQ(h.dbs_info->thermal_trip, -1);
+
+	// an active trip beyond a shortened table is clamped to it
+	h.dbs_info->thermal_temp = 90000;
+	CHECK_EQ(zz_get_thermal_cap(h.dbs_info, t), 600000);
+	STORE_OK(&h, "thermal_trips", "60000:1500000");
+	CHECK_EQ(zz_get_thermal_cap(h.dbs_info, zz_harness_snap(&h)), 1500000);
+
+	// the sampling path reads the zone and throttles down step by step
+	STORE_OK(&h, "thermal_trips", "60000:1500000 70000:1200000 80000:600000");
+	h.dbs_info->thermal_temp = 0;
+	zz_stub_tz.temperature = 90000;
+	set_cur(&h, 1800000);
+	zz_harness_sample(&h, (unsigned int []){ 100 }, 1, ZZ_THERMAL_POLL_INTERVAL * USEC_PER_MSEC);
+	zz_harness_sample(&h, (unsigned int []){ 100 }, 1, h.dbs_data.sampling_rate);
+	CHECK_EQ(h.dbs_info->max_scaling_freq_soft, 1);
+	CHECK_EQ(h.policy.cur, 1500000);
+	zz_harness_sample(&h, (unsigned int []){ 100 }, 1, h.dbs_data.sampling_rate);
+	zz_harness_sample(&h, (unsigned int []){ 100 }, 1, h.dbs_data.sampling_rate);
+	zz_harness_sample(&h, (unsigned int []){ 100 }, 1, h.dbs_data.sampling_rate);
+	CHECK_EQ(h.policy.cur, 600000);
+
+	// a zone which went away is not read anymore and the limit is released
+	zz_stub_tz.unregistered = true;
+	zz_harness_sample(&h, (unsigned int []){ 100 }, 1, ZZ_THERMAL_POLL_INTERVAL * USEC_PER_MSEC);
+	zz_harness_sample(&h, (unsigned int []){ 100 }, 1, h.dbs_data.sampling_rate);
+	CHECK_EQ(h.dbs_info->thermal_trip, -1);
+	CHECK_EQ(h.dbs_info->max_scaling_freq_soft, 5);
+	CHECK(h.policy.cur > 600000);
+	zz_stub_tz.unregistered = false;
+	zz_stub_tz.temperature = 0;
+
+	zz_harness_exit(&h);
+}
+
+static void test_parse_tuples(void)
+{
+	unsigned int vals[12];
+
+	CHECK_EQ(zz_parse_tuples("1:2 3:4", vals, 2, 4), 2);
+	CHECK_EQ(vals[0], 1);
+	CHECK_EQ(vals[1], 2);
+	CHECK_EQ(vals[2], 3);
+	CHECK_EQ(vals[3], 4);
+	CHECK_EQ(zz_parse_tuples("  5:6\n", vals, 2, 4), 1);
+	CHECK_EQ(vals[0], 5);
+	CHECK_EQ(vals[1], 6);
+	CHECK_EQ(zz_parse_tuples("100:80:40\t200:90:50", vals, 3, 4), 2);
+	CHECK_EQ(vals[5], 50);
+	CHECK_EQ(zz_parse_tuples("7", vals, 1, 4), 1);
+
+	// empty input clears
+	CHECK_EQ(zz_parse_tuples("", vals, 2, 4), 0);
+	CHECK_EQ(zz_parse_tuples("\n", vals, 2, 4), 0);
+
+	// malformed input and too many tuples
+	CHECK_EQ(zz_parse_tuples("1:2:3", vals, 2, 4), -EINVAL);
+	CHECK_EQ(zz_parse_tuples("1:2 3", vals, 2, 4), -EINVAL);
+	CHECK_EQ(zz_parse_tuples("1;2", vals, 2, 4), -EINVAL);
+	CHECK_EQ(zz_parse_tuples("a:2", vals, 2, 4), -EINVAL);
+	CHECK_EQ(zz_parse_tuples("1:2x", vals, 2, 4), -EINVAL);
+	CHECK_EQ(zz_parse_tuples("1:2 3:4 5:6", vals, 2, 2), -EINVAL);
+}
+
+// a store which can't publish must leave the tunables as the sampling path sees them
+static void test_publish_rollback(void)
+{
+	char buf[PAGE_SIZE];
+	struct zz_harness h;
+
+	init(&h, asc, ARRAY_SIZE(asc), 0, 0);
+
+	zz_stub_alloc_fail = 1;
+	CHECK_EQ(zz_harness_store(&h, "up_threshold", "90"), -ENOMEM);
+	zz_harness_show(&h, "up_threshold", buf);
+	CHECK(!strcmp(buf, "80\n"));
+	CHECK_EQ(zz_harness_snap(&h)->up_threshold, 80);
+
+	zz_stub_alloc_fail = 1;
+	CHECK_EQ(zz_harness_store(&h, "smooth_up", "50"), -ENOMEM);
+	zz_harness_show(&h, "smooth_up", buf);
+	CHECK(!strcmp(buf, "75\n"));
+
+	STORE_OK(&h, "opp_power", "300000:100");
+	zz_stub_alloc_fail = 2;
+	CHECK_EQ(zz_harness_store(&h, "opp_power", "600000:200"), -ENOMEM);
+	zz_harness_show(&h, "opp_power", buf);
+	CHECK(!strcmp(buf, "300000:100 \n"));
+
+	// a profile that couldn't be loaded is neither active nor stored
+	zz_stub_alloc_fail = 2;
+	CHECK_EQ(zz_harness_store(&h, "profile", "fast up_threshold=60"), -ENOMEM);
+	zz_harness_show(&h, "profile", buf);
+	CHECK(!strcmp(buf, "custom\n"));
+	CHECK_EQ(zz_profile_find(to_tuners_ext(&h.dbs_data), "fast"), -1);
+	zz_harness_show(&h, "up_threshold", buf);
+	CHECK(!strcmp(buf, "80\n"));
+
+	zz_stub_alloc_fail = 0;
+	zz_harness_exit(&h);
+}
+
+/*
+ * timing loop, ns per sampling path decision for different table sizes and scaling modes. loads are pseudo random
+ * so all decision paths are taken, the stub load calculation is part of the measured time like dbs_update() is
+ */
+static void bench(unsigned long samples)
+{
+	static const unsigned int sizes[] = { 8, 16, 32, 64 };
+	static const char *const modes[] = { "0", "1", "2", "4" };
+	unsigned int freqs[MAX_FREQ_TABLE_SIZE];
+	char power[MAX_FREQ_TABLE_SIZE * 24];
+	struct timespec start, end;
+	struct zz_harness h;
+	unsigned int s, m, i, load;
+	unsigned long n;
+	u32 seed;
+	u64 ns;
+	size_t len;
+
+	printf("%-6s %-5s %14s %14s\n", "steps", "mode", "ns/sample", "ns/next_freq");
+
+	for (s = 0; s < ARRAY_SIZE(sizes); s++) {
+		for (m = 0; m < ARRAY_SIZE(modes); m++) {
+			len = 0;
+			for (i = 0; i < sizes[s]; i++) {
+				freqs[i] = 300000 + i * (2100000 / sizes[s]);
+				len += snprintf(power + len, sizeof(power) - len, "%u:%u ", freqs[i],
+					100 + i * i * 10);
+			}
+
+			init(&h, freqs, sizes[s], 0, 0);
+			STORE_OK(&h, "scaling_proportional", modes[m]);
+			STORE_OK(&h, "opp_power", power);
+
+			seed = 1;
+			clock_gettime(CLOCK_MONOTONIC, &start);
+			for (n = 0; n < samples; n++) {
+				seed = seed * 1103515245 + 12345;
+				load = (seed >> 16) % 101;
+				zz_harness_sample(&h, &load, 1, h.dbs_data.sampling_rate);
+			}
+			clock_gettime(CLOCK_MONOTONIC, &end);
+			ns = (end.tv_sec - start.tv_sec) * 1000000000ULL + end.tv_nsec - start.tv_nsec;
+			printf("%-6u %-5s %14.1f", sizes[s], modes[m], (double)ns / samples);
+
+			seed = 1;
+			clock_gettime(CLOCK_MONOTONIC, &start);
+			for (n = 0; n < samples; n++) {
+				seed = seed * 1103515245 + 12345;
+				load = (seed >> 16) % 101;
+				h.policy.cur = zz_get_next_freq(h.policy.cur, load > 50, load, 80, &h.policy,
+					zz_harness_snap(&h));
+			}
+			clock_gettime(CLOCK_MONOTONIC, &end);
+			ns = (end.tv_sec - start.tv_sec) * 1000000000ULL + end.tv_nsec - start.tv_nsec;
+			printf(" %14.1f\n", (double)ns / samples);
+
+			zz_harness_exit(&h);
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 1 && !strcmp(argv[1], "bench")) {
+		bench(argc > 2 ? strtoul(argv[2], NULL, 0) : 200000);
+		return 0;
+	}
+
+	test_tables();
+	test_floor_ceil();
+	test_next_freq();
+	test_limits();
+	test_afs_level();
+	test_energy_freq();
+	test_factor_skip();
+	test_coord_floor();
+	test_iowait_boost();
+	test_adaptive_sampling();
+	test_fast_switch();
+	test_input_handler();
+	test_thermal_cap();
+	test_parse_tuples();
+	test_publish_rollback();
+
+	printf("zz_test: %u checks, %u failed\n", zz_checks, zz_failures);
+	return zz_failures ? 1 : 0;
+}